@@ -0,0 +1,155 @@
+#ifndef ARCHETYPE_HPP_INCLUDED
+#define ARCHETYPE_HPP_INCLUDED
+
+#include <vector>
+#include <tuple>
+#include <utility>
+#include "SlotMap.hpp"
+
+// Position of T in TTypes
+template<class T, class... TTypes>
+struct TypeIndex;
+
+template<class T, class... TRest>
+struct TypeIndex<T, T, TRest...>
+{
+    static constexpr unsigned int value = 0;
+};
+
+template<class T, class TFirst, class... TRest>
+struct TypeIndex<T, TFirst, TRest...>
+{
+    static constexpr unsigned int value = 1 + TypeIndex<T, TRest...>::value;
+};
+
+// Entities that all have the same components, every kind of component in its
+// own contiguous array, so systems walk them linearly without virtual calls.
+// Row i of every array belongs to the same entity. Destroying an entity moves
+// the last one into its row, so rows aren't stable; entities are named by
+// generational handles instead. The component types have to be distinct.
+template<class... TComponents>
+class Archetype
+{
+public:
+
+    typedef GenerationalHandle<Archetype<TComponents...> > Entity;
+
+private:
+
+    std::tuple<std::vector<TComponents>...>  columns;
+    SlotTable<Archetype<TComponents...> >     table;
+
+    template<class TComponent>
+    int moveRow(unsigned int to)
+    {
+        std::vector<TComponent>& components = getColumn<TComponent>();
+        if(to != components.size() - 1)
+        {
+            components[to] = std::move(components.back());
+        }
+        components.pop_back();
+        return 0;
+    }
+
+public:
+
+    unsigned int size() const
+    {
+        return table.size();
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    template<class TComponent>
+    std::vector<TComponent>& getColumn()
+    {
+        return std::get<TypeIndex<TComponent, TComponents...>::value>(columns);
+    }
+
+    template<class TComponent>
+    const std::vector<TComponent>& getColumn() const
+    {
+        return std::get<TypeIndex<TComponent, TComponents...>::value>(columns);
+    }
+
+    bool contains(const Entity& entity) const
+    {
+        return table.contains(entity);
+    }
+
+    // nullptr for a destroyed entity; valid until the next create or destroy
+    template<class TComponent>
+    TComponent* get(const Entity& entity)
+    {
+        return table.contains(entity) ? &getColumn<TComponent>()[table.getIndex(entity)] : nullptr;
+    }
+
+    template<class TComponent>
+    const TComponent* get(const Entity& entity) const
+    {
+        return table.contains(entity) ? &getColumn<TComponent>()[table.getIndex(entity)] : nullptr;
+    }
+
+    Entity getEntity(unsigned int row) const
+    {
+        return table.getHandle(row);
+    }
+
+    // Only for entities that still exist
+    unsigned int getRow(const Entity& entity) const
+    {
+        return table.getIndex(entity);
+    }
+
+    Entity create(TComponents... components)
+    {
+        int expand[] = {0, (getColumn<TComponents>().push_back(std::move(components)), 0)...};
+        (void)expand;
+        return table.insert();
+    }
+
+    // Returns false if the entity was already destroyed
+    bool destroy(const Entity& entity)
+    {
+        unsigned int row;
+        if(!table.erase(entity, row))
+        {
+            return false;
+        }
+        int expand[] = {0, moveRow<TComponents>(row)...};
+        (void)expand;
+        return true;
+    }
+
+    // Every entity handle given out so far becomes stale
+    void clear()
+    {
+        int expand[] = {0, (getColumn<TComponents>().clear(), 0)...};
+        (void)expand;
+        table.clear();
+    }
+
+    // function(components...) for every entity, with the selected components
+    template<class... TSelected, class TFunction>
+    void each(TFunction function)
+    {
+        for(unsigned int i=0; i<size(); i++)
+        {
+            function(getColumn<TSelected>()[i]...);
+        }
+    }
+
+    template<class... TSelected, class TFunction>
+    void each(TFunction function) const
+    {
+        for(unsigned int i=0; i<size(); i++)
+        {
+            function(getColumn<TSelected>()[i]...);
+        }
+    }
+};
+
+#endif // ARCHETYPE_HPP_INCLUDED
@@ -0,0 +1,117 @@
+#ifndef ARENA_HPP_INCLUDED
+#define ARENA_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "Pool.hpp"
+
+// Memory handed out by moving a pointer through big blocks, given back all at
+// once by reset(). Nothing is freed one by one, and destructors are left to
+// whoever creates the objects. The first block is kept over resets.
+class Arena
+{
+    struct Block
+    {
+        char*       data;
+        std::size_t size;
+    };
+
+    std::vector<Block>  blocks;
+    std::size_t         blockSize;
+    std::size_t         used;
+    std::size_t         totalUsed;
+
+    void addBlock(std::size_t minimalSize)
+    {
+        Block block;
+        block.size = std::max(blockSize, minimalSize);
+        block.data = static_cast<char*>(std::malloc(block.size));
+        if(!block.data)
+        {
+            throw std::bad_alloc();
+        }
+        AllocationStats::count();
+        blocks.push_back(block);
+        used = 0;
+    }
+
+public:
+
+    void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t))
+    {
+        if(!blocks.empty())
+        {
+            const Block& block = blocks.back();
+            std::uintptr_t address = reinterpret_cast<std::uintptr_t>(block.data) + used;
+            std::size_t padding = (alignment - address % alignment) % alignment;
+            if(used + padding + size <= block.size)
+            {
+                used      += padding + size;
+                totalUsed += padding + size;
+                return block.data + used - size;
+            }
+        }
+        addBlock(size + alignment);
+        return allocate(size, alignment);
+    }
+
+    template<class T, class... TArgs>
+    T* create(TArgs&&... args)
+    {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<TArgs>(args)...);
+    }
+
+    bool owns(const void* memory) const
+    {
+        const char* address = static_cast<const char*>(memory);
+        for(const Block& block : blocks)
+        {
+            if(address >= block.data && address < block.data + block.size)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::size_t getUsedBytes() const
+    {
+        return totalUsed;
+    }
+
+    void reset()
+    {
+        for(unsigned int i=1; i<blocks.size(); i++)
+        {
+            std::free(blocks[i].data);
+        }
+        if(blocks.size() > 1)
+        {
+            blocks.resize(1);
+        }
+        used      = 0;
+        totalUsed = 0;
+    }
+
+    Arena(std::size_t blockSize_ = 64 * 1024)
+        : blockSize(blockSize_), used(0), totalUsed(0)
+    {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena()
+    {
+        for(const Block& block : blocks)
+        {
+            std::free(block.data);
+        }
+    }
+};
+
+#endif // ARENA_HPP_INCLUDED
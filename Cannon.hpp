@@ -3,58 +3,97 @@
 
 #include "Object.hpp"
 #include "WallTurret.hpp"
+#include "ProjectileSystem.hpp"
 
-class Cannonball : public SpriteActor, public ActorCollection<Cannonball>
+// Cannonballs aren't actors, they are the rows of one ProjectileSystem
+class Cannonball
 {
-    
+
     static constexpr int colliderDiameter    = 5;
     static constexpr int colliderRadius      = colliderDiameter / 2;
-    
+
+    static constexpr double mass             = 500;
+    static constexpr double lifetime         = 10;
+    static constexpr double restSpeed        = 5;
+    static constexpr double restDuration     = 0.5;
+    // How far out of the rooms a ball may fly before it is gone for good
+    static constexpr double boundsMargin     = 200;
+
+	static ProjectileSystem createProjectiles()
+	{
+	    sf::Sprite sprite(textureManager.get(CannonballSprite::path, false), CannonballSprite::rect);
+	    sprite.setOrigin({colliderRadius + 1, colliderRadius + 1});
+	    ProjectileSystem projectiles(sprite, CollisionLayers::Projectile, CollisionLayers::Platform | CollisionLayers::Turret);
+	    projectiles.setDefaultLifetime(lifetime);
+	    projectiles.setRestDetection(restSpeed, restDuration);
+	    return projectiles;
+	}
+
 public:
-	
-	
-	
-	void update(double deltaTime)
+
+	// Created on first use, once the textures can be loaded
+	static ProjectileSystem& getProjectiles()
+	{
+	    static ProjectileSystem projectiles = createProjectiles();
+	    return projectiles;
+	}
+
+	// Turrets are shared between the balls, so a hit turret is only queued for
+	// despawning; being hit twice in a step is harmless. Until the queues are
+	// applied the turrets are only read.
+	static void hitTurret(const WallTurret::Entity& wallTurret)
+	{
+	    WallTurret::queueDespawn(wallTurret);
+	}
+
+	static void updateAll(double deltaTime, JobSystem& jobs = jobSystem)
 	{
-	    updateSubstepKinematics(deltaTime, 2, [this](double deltaTime)
+	    Rect<double> rooms = Room::getBounds();
+	    getProjectiles().setBounds(Rect<double>(rooms.position - Vector2d(boundsMargin, boundsMargin), rooms.size + Vector2d(boundsMargin, boundsMargin) * 2));
+	    getProjectiles().update(deltaTime, WallTurret::Targets(), [](const WallTurret::Entity& turret)
         {
-            WallTurret::iterate([&](WallTurret& wt)
-            {
-                handleCollision(*this, wt, [&](Collision::Result result, Cannonball& cannonball, WallTurret& wallTurret)
-                {
-                    wallTurret.setPosition({-100, -100});
-                });
-                return false;
-            });
-            moveOutOfWalls(platforms);
-            
-        });
+            hitTurret(turret);
+        }, jobs);
+	}
+
+	static void captureAll(RenderSnapshot& snapshot)
+	{
+	    getProjectiles().capture(snapshot);
+	}
+
+	static void drawAll(SpriteBatch& batch, double interpolation = 1)
+	{
+	    getProjectiles().draw(batch, interpolation);
+	}
+
+	static void drawAll(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default, double interpolation = 1)
+	{
+	    getProjectiles().draw(target, states, interpolation);
 	}
-	
+
+	static unsigned int getCount()
+	{
+	    return getProjectiles().size();
+	}
+
 	static bool shoot(const Vector2d& position_ = Vectors::null, const Vector2d& velocity_ = Vectors::null)
 	{
 	    if(Room::isPointInside(position_))
         {
-            spawn(new Cannonball(position_, velocity_));
+            CommandBuffer::defer([position_, velocity_]
+            {
+                getProjectiles().spawn(position_, velocity_, colliderRadius, mass);
+            });
             return true;
         }
         return false;
 	}
-		
-	Cannonball(const Vector2d& position_ = Vectors::null, const Vector2d& velocity_ = Vectors::null)
-		: SpriteActor(textureManager.get(CannonballSprite::path, false), CannonballSprite::rect)
-	{
-		mass = 500;
-		velocity = velocity_;
-		setPosition(position_);
-		sprite.setOrigin({colliderRadius + 1, colliderRadius + 1});
-		setCollider(Circle<double>(Vector2d(0, 0), colliderRadius));
-		//setCollider(Rect<double>(Vector2d(-colliderRadius, -colliderRadius), Vector2d(colliderRadius, colliderRadius)));
-	}
-	
-	virtual ~Cannonball(){};
 };
 
-//std::vector<Cannonball*> ActorCollection<Cannonball>::list;
+constexpr double Cannonball::mass;
+constexpr double Cannonball::lifetime;
+constexpr double Cannonball::restSpeed;
+constexpr double Cannonball::restDuration;
+constexpr double Cannonball::boundsMargin;
 
 #endif // CANNON_HPP_INCLUDED
@@ -2,6 +2,9 @@
 #define COLISIONS_HPP_INCLUDED
 
 #include "Shapes.hpp"
+#include "Pool.hpp"
+#include <atomic>
+#include <thread>
 
 using eType = double;
 
@@ -105,11 +108,10 @@ namespace CollisionFast
             return false;
         }
         
-        Line<B> edge;
         bool res = false;
         for (unsigned int i = 0; i < poly.points.size(); i++) 
         {
-            edge = poly.getEdgeLine(i);
+            Line<B> edge = poly.getEdgeLine(i);
             if ( ((edge.point2.y > point.y) != (edge.point1.y > point.y)) &&
                  (point.x < (edge.point1.x - edge.point2.x) * (point.y - edge.point2.y) / (edge.point1.y - edge.point2.y) + edge.point2.x) )
             {
@@ -528,13 +530,13 @@ namespace Collision
                     set = true;
                     double temp = edgeVectorUnit.x;
                     edgeVectorUnit.x = edgeVectorUnit.y;
-                    edgeVectorUnit.x = -temp;
+                    edgeVectorUnit.y = -temp;
                     
                     mtv = edgeVectorUnit * tempCross;
                     bestCross = tempCross;
                 }
             }
-            return Result(true, mtv.x, mtv.y, bestCross, std::sqrt(minDistance));
+            return Result(true, mtv.x, mtv.y, std::sqrt(minDistance));
         }
         
         return Result(false);
@@ -744,11 +746,215 @@ namespace Collision
 	}
 	template <class T>
 	Result test(const SimpleSegment<T>& ssegment, const Polygon<T>& poly){return -test(poly, ssegment);}
+
+	// Line (as a ray from point1 to point2) - SSegment
+	// fraction is the hit position along the line, 0 at point1 and 1 at point2
+	template <class T>
+	bool raycast(const Line<T>& ray, const SimpleSegment<T>& ssegment, double& fraction)
+	{
+	    Vector2<T> direction = ray.toVector();
+	    double d = ssegment.isVertical ? direction.x : direction.y;
+	    double o = ssegment.isVertical ? ray.point1.x : ray.point1.y;
+	    if(d == 0)
+        {
+            return false;
+        }
+        fraction = (ssegment.getOffset() - o) / d;
+        if(fraction < 0 || fraction > 1)
+        {
+            return false;
+        }
+        double along = ssegment.isVertical ? ray.point1.y + direction.y * fraction : ray.point1.x + direction.x * fraction;
+        return along >= ssegment.getStartValue() && along <= ssegment.getEndValue();
+	}
+	
+	// Ray origin + direction * fraction, fraction in [0,1], entering the circle.
+	// Rays starting inside don't enter it.
+	template <class T>
+	bool raycast(const Vector2<T>& origin, const Vector2<T>& direction, const Circle<T>& circle, double& fraction)
+	{
+	    Vector2<T> toOrigin = origin - circle.position;
+	    double a = direction.dot(direction);
+	    double b = toOrigin.dot(direction);
+	    double c = toOrigin.dot(toOrigin) - circle.radius * circle.radius;
+	    if(a == 0 || c < 0)
+        {
+            return false;
+        }
+        double discriminant = b*b - a*c;
+        if(discriminant < 0)
+        {
+            return false;
+        }
+        fraction = (-b - std::sqrt(discriminant)) / a;
+        return fraction >= 0 && fraction <= 1;
+	}
+	
+	// Same for an axis aligned rect, slab test
+	template <class T>
+	bool raycast(const Vector2<T>& origin, const Vector2<T>& direction, const Rect<T>& rect, double& fraction)
+	{
+	    double tEnter = -1;
+	    double tExit  = 2;
+	    const double o[2]  = {origin.x, origin.y};
+	    const double d[2]  = {direction.x, direction.y};
+	    const double mn[2] = {rect.position.x, rect.position.y};
+	    const double mx[2] = {rect.position.x + rect.size.x, rect.position.y + rect.size.y};
+	    for(int axis = 0; axis < 2; axis++)
+        {
+            if(d[axis] == 0)
+            {
+                if(o[axis] < mn[axis] || o[axis] > mx[axis])
+                {
+                    return false;
+                }
+                continue;
+            }
+            double t1 = (mn[axis] - o[axis]) / d[axis];
+            double t2 = (mx[axis] - o[axis]) / d[axis];
+            tEnter = std::max(tEnter, std::min(t1, t2));
+            tExit  = std::min(tExit,  std::max(t1, t2));
+        }
+        if(tEnter > tExit || tEnter < 0 || tEnter > 1)
+        {
+            return false;
+        }
+        fraction = tEnter;
+        return true;
+	}
+	
+	// Swept Circle - SSegment and Circle - Rect.
+	// The circle moved by displacement is a ray against the shape grown by the radius:
+	// a box along every face plus a circle at every corner. The earliest entry is the
+	// time of impact, normal points from the shape towards the circle at that moment.
+	// Contacts the circle is moving away from (or sliding along) are not reported.
+	template <class T>
+	bool sweep(const Circle<T>& circle, const Vector2<T>& displacement, const Rect<T>& rect, double& fraction, Vector2d& normal)
+	{
+	    const T r = circle.radius;
+	    bool hit = false;
+	    double t;
+	    fraction = 2;
+	    
+	    const Rect<T> faces[2] = {  Rect<T>(rect.position.x - r, rect.position.y, rect.size.x + 2*r, rect.size.y),
+                                    Rect<T>(rect.position.x, rect.position.y - r, rect.size.x, rect.size.y + 2*r)};
+        for(const Rect<T>& face : faces)
+        {
+            if(raycast(circle.position, displacement, face, t) && t < fraction)
+            {
+                hit = true;
+                fraction = t;
+            }
+        }
+        const Vector2<T> corners[4] = {rect.getUpperLeft(), rect.getUpperRight(), rect.getBottomLeft(), rect.getBottomRight()};
+        for(const Vector2<T>& corner : corners)
+        {
+            if(raycast(circle.position, displacement, Circle<T>(corner, r), t) && t < fraction)
+            {
+                hit = true;
+                fraction = t;
+            }
+        }
+        if(!hit)
+        {
+            return false;
+        }
+        
+        Vector2<T> center = circle.position + displacement * fraction;
+        Vector2<T> closest( std::min(std::max(center.x, rect.position.x), rect.position.x + rect.size.x),
+                            std::min(std::max(center.y, rect.position.y), rect.position.y + rect.size.y));
+        normal = (center - closest).normalize();
+        return normal.dot(displacement) < 0;
+	}
 	
+	template <class T>
+	bool sweep(const Circle<T>& circle, const Vector2<T>& displacement, const SimpleSegment<T>& ssegment, double& fraction, Vector2d& normal)
+	{
+	    return sweep(circle, displacement, Rect<T>(ssegment.position, ssegment.getVector()), fraction, normal);
+	}
+
+}
+
+// Pairwise tests for the closed set of collider shapes. Every shape type gets a
+// tag, and Collision::dispatch picks the matching Collision::test overload from
+// a table of function pointers generated at compile time, so a collider pair
+// costs one indirect call instead of two virtual hops.
+namespace Collision
+{
+    enum ShapeType
+    {
+        RectShape,
+        CircleShape,
+        SimpleSegmentShape,
+        LineShape,
+        PolygonShape,
+        ShapeTypesCount
+    };
+    
+    template<class T> struct ShapeTypeOf;
+    template<> struct ShapeTypeOf<Rect<double> >            {static constexpr ShapeType value = RectShape;};
+    template<> struct ShapeTypeOf<Circle<double> >          {static constexpr ShapeType value = CircleShape;};
+    template<> struct ShapeTypeOf<SimpleSegment<double> >   {static constexpr ShapeType value = SimpleSegmentShape;};
+    template<> struct ShapeTypeOf<Line<double> >            {static constexpr ShapeType value = LineShape;};
+    template<> struct ShapeTypeOf<Polygon<double> >         {static constexpr ShapeType value = PolygonShape;};
+    
+    typedef Result (*PairTest)(const void*, const void*);
+    
+    template<class A, class B>
+    Result pairTest(const void* a, const void* b)
+    {
+        return test(*static_cast<const A*>(a), *static_cast<const B*>(b));
+    }
+    
+    // Shapes have to be listed in the same order as in ShapeType
+    template<class... TShapes>
+    struct DispatchTable
+    {
+        static constexpr unsigned int size = sizeof...(TShapes);
+        
+        struct Row
+        {
+            PairTest tests[size];
+        };
+        
+        template<class A>
+        static constexpr Row makeRow()
+        {
+            return Row{{&pairTest<A, TShapes>...}};
+        }
+        
+        static constexpr Row rows[size] = {makeRow<TShapes>()...};
+    };
+    template<class... TShapes>
+    constexpr typename DispatchTable<TShapes...>::Row DispatchTable<TShapes...>::rows[];
+    
+    typedef DispatchTable<Rect<double>, Circle<double>, SimpleSegment<double>, Line<double>, Polygon<double> > ShapeDispatchTable;
+    static_assert(ShapeDispatchTable::size == ShapeTypesCount, "Every ShapeType needs an entry in ShapeDispatchTable");
+    
+    inline Result dispatch(ShapeType typeA, const void* a, ShapeType typeB, const void* b)
+    {
+        return ShapeDispatchTable::rows[typeA].tests[typeB](a, b);
+    }
 }
 
 class Collider;
 
+// Every collider sits on one or more layers and has a mask of the layers it
+// collides with. A pair is tested only if each mask accepts the other layer.
+namespace CollisionLayers
+{
+    enum : unsigned int
+    {
+        None        = 0,
+        Default     = 1 << 0,
+        Platform    = 1 << 1,
+        Player      = 1 << 2,
+        Projectile  = 1 << 3,
+        Turret      = 1 << 4,
+        All         = ~0u
+    };
+}
+
 class Collidable
 {
 public:
@@ -811,24 +1017,111 @@ protected:
     
     static void _getPositionedCollider(const Line<double>& collider, Line<double>& positionedCollider, const Vector2<double>& position, const Vector2<double>& scale, double rotation)
     {
-        
-        Line<double> newCollider = collider;
-        newCollider.scaleSelf(scale);
-        newCollider.rotateSelf(rotation);
-        newCollider.moveSelf(position);
-        
-        positionedCollider = newCollider;
+        _getPositionedCollider(collider, positionedCollider, position, scale, rotation, std::cos(toRadians(rotation)), std::sin(toRadians(rotation)));
     }
     
     static void _getPositionedCollider(const Polygon<double>& collider, Polygon<double>& positionedCollider, const Vector2<double>& position, const Vector2<double>& scale, double rotation)
     {
-        
-        Polygon<double> newCollider = collider;
-        newCollider.scaleSelf(scale);
-        newCollider.rotateSelf(rotation);
-        newCollider.moveSelf(position);
-        
-        positionedCollider = newCollider;
+        _getPositionedCollider(collider, positionedCollider, position, scale, rotation, std::cos(toRadians(rotation)), std::sin(toRadians(rotation)));
+    }
+    
+    // Variants taking the sine and cosine of the rotation precomputed.
+    // The positioned shape is rebuilt in place, so its storage gets reused.
+    template<class T>
+    static void _getPositionedCollider(const T& collider, T& positionedCollider, const Vector2<double>& position, const Vector2<double>& scale, double rotation, double /*cosRotation*/, double /*sinRotation*/)
+    {
+        _getPositionedCollider(collider, positionedCollider, position, scale, rotation);
+    }
+    static void _getPositionedCollider(const Circle<double>& collider, Circle<double>& positionedCollider, const Vector2<double>& position, const Vector2<double>& scale, double /*rotation*/, double cosRotation, double sinRotation)
+    {
+        positionedCollider = Circle<double>((position * scale).rotateSelf(cosRotation, sinRotation) + collider.position, std::abs(scale.x) * collider.radius);
+    }
+    static void _getPositionedCollider(const Line<double>& collider, Line<double>& positionedCollider, const Vector2<double>& position, const Vector2<double>& scale, double /*rotation*/, double cosRotation, double sinRotation)
+    {
+        positionedCollider = collider;
+        positionedCollider.scaleSelf(scale);
+        positionedCollider.rotateSelf(cosRotation, sinRotation);
+        positionedCollider.moveSelf(position);
+    }
+    static void _getPositionedCollider(const Polygon<double>& collider, Polygon<double>& positionedCollider, const Vector2<double>& position, const Vector2<double>& scale, double /*rotation*/, double cosRotation, double sinRotation)
+    {
+        positionedCollider = collider;
+        positionedCollider.scaleSelf(scale);
+        positionedCollider.rotateSelf(cosRotation, sinRotation);
+        positionedCollider.moveSelf(position);
+    }
+    
+    // Moves an already positioned shape after a pure change of position
+    static void _translatePositionedCollider(Rect<double>& positionedCollider, const Vector2<double>& shift, const Vector2<double>& /*scale*/, double /*cosRotation*/, double /*sinRotation*/)
+    {
+        positionedCollider.position += shift;
+    }
+    static void _translatePositionedCollider(Circle<double>& positionedCollider, const Vector2<double>& shift, const Vector2<double>& scale, double cosRotation, double sinRotation)
+    {
+        positionedCollider.position += (shift * scale).rotateSelf(cosRotation, sinRotation);
+    }
+    static void _translatePositionedCollider(SimpleSegment<double>& positionedCollider, const Vector2<double>& shift, const Vector2<double>& scale, double /*cosRotation*/, double /*sinRotation*/)
+    {
+        positionedCollider.position += shift * scale;
+    }
+    static void _translatePositionedCollider(Line<double>& positionedCollider, const Vector2<double>& shift, const Vector2<double>& /*scale*/, double /*cosRotation*/, double /*sinRotation*/)
+    {
+        positionedCollider.moveSelf(shift);
+    }
+    static void _translatePositionedCollider(Polygon<double>& positionedCollider, const Vector2<double>& shift, const Vector2<double>& /*scale*/, double /*cosRotation*/, double /*sinRotation*/)
+    {
+        positionedCollider.moveSelf(shift);
+    }
+    
+    // Set by the shape colliders, points at the shape used for testing
+    Collision::ShapeType    shapeType;
+    const void*             shape;
+    
+    enum ShapeState{ShapeClean, ShapeDirty, ShapeRefreshing};
+    
+    // Shape colliders rebuild their positioned shape only when it is needed
+    // after a transform change; refreshShape is called for that. Tests from
+    // several jobs may need the same collider at once, so the first one
+    // claims the rebuild and the others wait for it to finish.
+    mutable std::atomic<int> shapeState;
+    void                    (*refreshShape)(const Collider&);
+    
+    unsigned int            layer;
+    unsigned int            mask;
+    
+    Collider(Collision::ShapeType shapeType_, const void* shape_, void (*refreshShape_)(const Collider&) = nullptr)
+        : shapeType(shapeType_), shape(shape_), shapeState(ShapeClean), refreshShape(refreshShape_),
+          layer(CollisionLayers::Default), mask(CollisionLayers::All)
+    {}
+    
+    bool isShapeDirty() const
+    {
+        return shapeState.load(std::memory_order_acquire) != ShapeClean;
+    }
+    
+    // Only from the thread owning the collider, like every other change to it
+    void markShapeDirty()
+    {
+        shapeState.store(ShapeDirty, std::memory_order_release);
+    }
+    
+    void refresh() const
+    {
+        int state = shapeState.load(std::memory_order_acquire);
+        while(state != ShapeClean)
+        {
+            if(state == ShapeDirty && shapeState.compare_exchange_weak(state, ShapeRefreshing, std::memory_order_acquire))
+            {
+                refreshShape(*this);
+                shapeState.store(ShapeClean, std::memory_order_release);
+                return;
+            }
+            if(state == ShapeRefreshing)
+            {
+                std::this_thread::yield();
+            }
+            state = shapeState.load(std::memory_order_acquire);
+        }
     }
     
 public:
@@ -837,15 +1130,64 @@ public:
         return this;
     }
     
+    Collision::ShapeType getShapeType() const
+    {
+        return shapeType;
+    }
+    
+    unsigned int getLayer() const
+    {
+        return layer;
+    }
+    unsigned int getMask() const
+    {
+        return mask;
+    }
+    void setLayer(unsigned int layer_)
+    {
+        layer = layer_;
+    }
+    void setMask(unsigned int mask_)
+    {
+        mask = mask_;
+    }
+    
+    bool canCollideWith(const Collider& c) const
+    {
+        return (mask & c.layer) && (c.mask & layer);
+    }
+    
+    // Positioned shape, or nullptr if the collider holds a different shape type
+    template<class T>
+    const T* getShape() const
+    {
+        if(shapeType != Collision::ShapeTypeOf<T>::value)
+        {
+            return nullptr;
+        }
+        refresh();
+        return static_cast<const T*>(shape);
+    }
+    
     virtual ~Collider(){};
     virtual Collider* clonePtr() const = 0;
-    virtual Collision::Result test(const Collider&) const =0;
+    Collision::Result test(const Collider& c) const
+    {
+        if(!canCollideWith(c))
+        {
+            return Collision::Result(false);
+        }
+        refresh();
+        c.refresh();
+        return Collision::dispatch(shapeType, shape, c.shapeType, c.shape);
+    }
     virtual Collision::Result test(const Rect<double>&) const =0;
     virtual Collision::Result test(const Circle<double>&) const =0;
     virtual Collision::Result test(const SimpleSegment<double>&) const =0;
     virtual Collision::Result test(const Line<double>&) const =0;
     virtual Collision::Result test(const Polygon<double>&) const =0;
     virtual void updateCollider(const Vector2<double>& position = Vectors::null, const Vector2<double>& scale = Vectors::units, double rotation = 0) =0;
+    virtual Rect<double> getBoundingRect() const =0;
     void updateCollider(const Transformable& transform)
     {
         updateCollider(transform.getPosition(), transform.getScale(), transform.getRotation());
@@ -862,78 +1204,154 @@ public:
 };
 
 template <class T>
-class ShapeCollider : public Collider
+class ShapeCollider : public Collider, public Pooled<ShapeCollider<T> >
 {
 	
-	T positionedCollider;
+	mutable T               positionedCollider;
+	mutable Rect<double>    boundingRect;
+	
+	Vector2<double> position;
+	Vector2<double> scale;
+	double          rotation;
+	double          cosRotation;
+	double          sinRotation;
+	
+	static void refreshPositionedCollider(const Collider& c)
+	{
+	    const ShapeCollider<T>& self = static_cast<const ShapeCollider<T>&>(c);
+	    _getPositionedCollider(self.collider, self.positionedCollider, self.position, self.scale, self.rotation, self.cosRotation, self.sinRotation);
+	    self.boundingRect = self.positionedCollider.getBoundingRect();
+	}
+	
 public:
     T collider;
     ShapeCollider(T c)
-        : positionedCollider(c), collider(c)
+        : Collider(Collision::ShapeTypeOf<T>::value, &positionedCollider, &refreshPositionedCollider), positionedCollider(c), boundingRect(c.getBoundingRect()),
+          position(Vectors::null), scale(Vectors::units), rotation(0), cosRotation(1), sinRotation(0), collider(c)
     {}
+    ShapeCollider(const ShapeCollider<T>& c)
+        : Collider(c.shapeType, &positionedCollider, &refreshPositionedCollider), positionedCollider(c.positionedCollider), boundingRect(c.boundingRect),
+          position(c.position), scale(c.scale), rotation(c.rotation), cosRotation(c.cosRotation), sinRotation(c.sinRotation), collider(c.collider)
+    {
+        shapeState   = c.isShapeDirty() ? ShapeDirty : ShapeClean;
+        layer        = c.layer;
+        mask         = c.mask;
+    }
+    ShapeCollider<T>& operator=(const ShapeCollider<T>& c)
+    {
+        positionedCollider  = c.positionedCollider;
+        boundingRect        = c.boundingRect;
+        position            = c.position;
+        scale               = c.scale;
+        rotation            = c.rotation;
+        cosRotation         = c.cosRotation;
+        sinRotation         = c.sinRotation;
+        collider            = c.collider;
+        shapeState          = c.isShapeDirty() ? ShapeDirty : ShapeClean;
+        layer               = c.layer;
+        mask                = c.mask;
+        return *this;
+    }
     
     virtual Collider* clonePtr() const
     {
-    	Collider* res = new ShapeCollider<T>(collider);
+    	Collider* res = new ShapeCollider<T>(*this);
     	return res;
     }
 
-    virtual Collision::Result test(const Collider& c) const
-    {
-        return c.test(positionedCollider);
-    }
+    using Collider::test;
     virtual Collision::Result test(const Rect<double>& c) const
     {
+        refresh();
         return Collision::test(c, positionedCollider);
     }
     virtual Collision::Result test(const Circle<double>& c) const
     {
+        refresh();
         return Collision::test(c, positionedCollider);
     }
     virtual Collision::Result test(const SimpleSegment<double>& c) const
     {
+        refresh();
         return Collision::test(c, positionedCollider);
     }
     virtual Collision::Result test(const Line<double>& c) const
     {
+        refresh();
         return Collision::test(c, positionedCollider);
     }
     virtual Collision::Result test(const Polygon<double>& c) const
     {
+        refresh();
         return Collision::test(c, positionedCollider);
     }
-    virtual void updateCollider(const Vector2<double>& position = Vectors::null, const Vector2<double>& scale = Vectors::units, double rotation = 0)
+    
+    // Only records the transform. A pure change of position is applied to the
+    // positioned shape right away, anything else marks it for a rebuild.
+    virtual void updateCollider(const Vector2<double>& position_ = Vectors::null, const Vector2<double>& scale_ = Vectors::units, double rotation_ = 0)
     {
-        _getPositionedCollider(collider, positionedCollider, position, scale, rotation);
+        if(!isShapeDirty() && scale_.x == scale.x && scale_.y == scale.y && rotation_ == rotation)
+        {
+            Vector2<double> shift = position_ - position;
+            _translatePositionedCollider(positionedCollider, shift, scale, cosRotation, sinRotation);
+            boundingRect = positionedCollider.getBoundingRect();
+            position = position_;
+            return;
+        }
+        if(rotation_ != rotation)
+        {
+            rotation    = rotation_;
+            cosRotation = std::cos(toRadians(rotation));
+            sinRotation = std::sin(toRadians(rotation));
+        }
+        position     = position_;
+        scale        = scale_;
+        markShapeDirty();
+    }
+    virtual Rect<double> getBoundingRect() const
+    {
+        refresh();
+        return boundingRect;
     }
     virtual ~ShapeCollider(){};
     
     T getPositionedCollider()
     {
+        refresh();
         return positionedCollider;
     }
 };
 
 template <class T>
-class FixedShapeCollider : public Collider
+class FixedShapeCollider : public Collider, public Pooled<FixedShapeCollider<T> >
 {
 	
 public:
     T collider;
     FixedShapeCollider(T c)
-        : collider(c)
+        : Collider(Collision::ShapeTypeOf<T>::value, &collider), collider(c)
     {}
+    FixedShapeCollider(const FixedShapeCollider<T>& c)
+        : Collider(c.shapeType, &collider), collider(c.collider)
+    {
+        layer = c.layer;
+        mask  = c.mask;
+    }
+    FixedShapeCollider<T>& operator=(const FixedShapeCollider<T>& c)
+    {
+        collider = c.collider;
+        layer    = c.layer;
+        mask     = c.mask;
+        return *this;
+    }
     
     virtual Collider* clonePtr() const
     {
-    	Collider* res = new FixedShapeCollider<T>(collider);
+    	Collider* res = new FixedShapeCollider<T>(*this);
     	return res;
     }
 
-    virtual Collision::Result test(const Collider& c) const
-    {
-        return c.test(collider);
-    }
+    using Collider::test;
     virtual Collision::Result test(const Rect<double>& c) const
     {
         return Collision::test(c, collider);
@@ -958,6 +1376,10 @@ public:
     {
         return;
     }
+    virtual Rect<double> getBoundingRect() const
+    {
+        return collider.getBoundingRect();
+    }
     virtual ~FixedShapeCollider(){};
 };
 
@@ -976,7 +1398,13 @@ typedef FixedShapeCollider<Polygon<double> >        FixedPolygonCollider;
 template<typename TObject1, typename TObject2, typename THandler>
 void handleCollision(TObject1& object1, TObject2& object2, THandler handler)
 {
-    Collision::Result result = object1.getCollider()->test(object2.getCollider());
+    const Collider* collider1 = object1.getCollider();
+    const Collider* collider2 = object2.getCollider();
+    if(!collider1 || !collider2 || !collider1->canCollideWith(*collider2))
+    {
+        return;
+    }
+    Collision::Result result = collider1->test(*collider2);
     if(result)
     {
 		handler(result, object1, object2);
@@ -986,6 +1414,11 @@ void handleCollision(TObject1& object1, TObject2& object2, THandler handler)
 template<typename TObject, typename TFwdIterator, typename THandler>
 void handleAllCollisions(TObject& object, TFwdIterator begin, TFwdIterator end, THandler handler)
 {
+    const Collider* collider = object.getCollider();
+    if(!collider || collider->getMask() == CollisionLayers::None)
+    {
+        return;
+    }
     for(auto it = begin; it < end; it++)
     {
         handleCollision(object, *it, handler);
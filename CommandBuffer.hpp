@@ -0,0 +1,103 @@
+#ifndef COMMANDBUFFER_HPP_INCLUDED
+#define COMMANDBUFFER_HPP_INCLUDED
+
+#include <vector>
+#include <functional>
+
+// Changes to shared state recorded by a job, to be applied later on one thread.
+// While a job runs, its thread has a current buffer; code that may run inside
+// a job goes through defer(), which runs the command right away otherwise.
+// Every command carries the order of the job that recorded it, so commands
+// of several buffers can be merged into an order not depending on which
+// thread ran which job.
+class CommandBuffer
+{
+public:
+
+    struct Command
+    {
+        unsigned int            order;
+        std::function<void()>   function;
+    };
+
+private:
+
+    std::vector<Command> commands;
+    unsigned int         order = 0;
+
+    static thread_local CommandBuffer* current;
+
+public:
+
+    void push(const std::function<void()>& command)
+    {
+        commands.push_back(Command{order, command});
+    }
+
+    // Commands run in the order they were pushed
+    void execute()
+    {
+        for(auto& command : commands)
+        {
+            command.function();
+        }
+        commands.clear();
+    }
+
+    // Moves the commands to the end of merged, in the order they were pushed
+    void takeCommands(std::vector<Command>& merged)
+    {
+        for(auto& command : commands)
+        {
+            merged.push_back(std::move(command));
+        }
+        commands.clear();
+    }
+
+    bool empty() const
+    {
+        return commands.empty();
+    }
+
+    static CommandBuffer* getCurrent()
+    {
+        return current;
+    }
+
+    template<class TCommand>
+    static void defer(TCommand command)
+    {
+        if(current)
+        {
+            current->push(command);
+        }
+        else
+        {
+            command();
+        }
+    }
+
+    // Makes a buffer current for the lifetime of the scope; commands pushed
+    // meanwhile get the order
+    class Scope
+    {
+        CommandBuffer* previous;
+        unsigned int   previousOrder;
+    public:
+        Scope(CommandBuffer& buffer, unsigned int order = 0)
+            : previous(current), previousOrder(buffer.order)
+        {
+            current      = &buffer;
+            buffer.order = order;
+        }
+        ~Scope()
+        {
+            current->order = previousOrder;
+            current        = previous;
+        }
+    };
+};
+
+thread_local CommandBuffer* CommandBuffer::current = nullptr;
+
+#endif // COMMANDBUFFER_HPP_INCLUDED
@@ -0,0 +1,117 @@
+#ifndef COMPONENTS_HPP_INCLUDED
+#define COMPONENTS_HPP_INCLUDED
+
+#include <SFML/Graphics.hpp>
+#include "Vectors.hpp"
+#include "Shapes.hpp"
+#include "RenderSnapshot.hpp"
+#include "SpriteBatch.hpp"
+#include "Archetype.hpp"
+
+// Components shared by the archetypes; the ones only one archetype uses live
+// with it. Every component is a plain struct without virtual functions.
+namespace Components
+{
+    struct Position
+    {
+        Vector2d value;
+    };
+
+    // Position at the start of the last simulation step
+    struct PreviousPosition
+    {
+        Vector2d value;
+    };
+
+    struct Velocity
+    {
+        Vector2d value;
+    };
+
+    struct Mass
+    {
+        double value;
+    };
+
+    // Axis aligned box in world coordinates
+    struct Bounds
+    {
+        Rect<double> value;
+    };
+
+    struct Sprite
+    {
+        sf::Sprite value;
+    };
+}
+
+// Functions walking the columns of any archetype having the components they use
+namespace Systems
+{
+    template<class TArchetype>
+    void savePreviousPositions(TArchetype& archetype)
+    {
+        std::vector<Components::Position>&         positions = archetype.template getColumn<Components::Position>();
+        std::vector<Components::PreviousPosition>& previous  = archetype.template getColumn<Components::PreviousPosition>();
+        for(unsigned int i=0; i<positions.size(); i++)
+        {
+            previous[i].value = positions[i].value;
+        }
+    }
+
+    template<class TArchetype>
+    void applyGravity(TArchetype& archetype, const Vector2d& gravity, double deltaTime)
+    {
+        std::vector<Components::Velocity>&  velocities = archetype.template getColumn<Components::Velocity>();
+        const std::vector<Components::Mass>& masses    = archetype.template getColumn<Components::Mass>();
+        for(unsigned int i=0; i<velocities.size(); i++)
+        {
+            velocities[i].value += gravity * (masses[i].value * deltaTime);
+        }
+    }
+
+    template<class TArchetype>
+    void applyDrag(TArchetype& archetype, double drag, double deltaTime)
+    {
+        std::vector<Components::Velocity>& velocities = archetype.template getColumn<Components::Velocity>();
+        const double factor = 1 - drag * deltaTime;
+        for(unsigned int i=0; i<velocities.size(); i++)
+        {
+            velocities[i].value *= factor;
+        }
+    }
+
+    // Pushes the positions to the sprites, once per step instead of on every move
+    template<class TArchetype>
+    void syncSprites(TArchetype& archetype)
+    {
+        const std::vector<Components::Position>& positions = archetype.template getColumn<Components::Position>();
+        std::vector<Components::Sprite>&         sprites   = archetype.template getColumn<Components::Sprite>();
+        for(unsigned int i=0; i<positions.size(); i++)
+        {
+            sprites[i].value.setPosition(positions[i].value);
+        }
+    }
+
+    template<class TArchetype>
+    void captureSprites(const TArchetype& archetype, RenderSnapshot& snapshot)
+    {
+        archetype.template each<Components::Sprite, Components::Position, Components::PreviousPosition>(
+            [&snapshot](const Components::Sprite& sprite, const Components::Position& position, const Components::PreviousPosition& previous)
+        {
+            snapshot.addSprite(sprite.value, position.value - previous.value);
+        });
+    }
+
+    template<class TArchetype>
+    void drawSprites(const TArchetype& archetype, SpriteBatch& batch, double interpolation)
+    {
+        archetype.template each<Components::Sprite, Components::Position, Components::PreviousPosition>(
+            [&](const Components::Sprite& sprite, const Components::Position& position, const Components::PreviousPosition& previous)
+        {
+            batch.add(sprite.value, RenderSnapshot::interpolate(position.value, position.value - previous.value, interpolation) - position.value);
+        });
+    }
+}
+
+#endif // COMPONENTS_HPP_INCLUDED
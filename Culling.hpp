@@ -0,0 +1,63 @@
+#ifndef CULLING_HPP_INCLUDED
+#define CULLING_HPP_INCLUDED
+
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include "Vectors.hpp"
+#include "Shapes.hpp"
+
+// Drawing only what intersects the view. The draw paths test their own
+// bounds against getViewRect and report here how many objects they skipped
+// and how many they submitted, for the stats.
+class Culling
+{
+    static std::atomic<unsigned int> culled;
+    static std::atomic<unsigned int> submitted;
+
+public:
+
+    // World area the view shows; views aren't rotated, so it is exact
+    static Rect<double> getViewRect(const sf::View& view)
+    {
+        const Vector2d size   = view.getSize();
+        const Vector2d center = view.getCenter();
+        return Rect<double>(center - size / 2.0, size);
+    }
+
+    static bool isVisible(const Rect<double>& bounds, const Rect<double>& view)
+    {
+        return bounds.position.x <= view.position.x + view.size.x && bounds.position.x + bounds.size.x >= view.position.x &&
+               bounds.position.y <= view.position.y + view.size.y && bounds.position.y + bounds.size.y >= view.position.y;
+    }
+
+    static void count(unsigned int culled_, unsigned int submitted_)
+    {
+        culled    += culled_;
+        submitted += submitted_;
+    }
+
+    // Counts the object and returns whether it is visible
+    static bool test(const Rect<double>& bounds, const Rect<double>& view)
+    {
+        bool visible = isVisible(bounds, view);
+        count(visible ? 0 : 1, visible ? 1 : 0);
+        return visible;
+    }
+
+    // Objects skipped since the last call
+    static unsigned int takeCulled()
+    {
+        return culled.exchange(0);
+    }
+
+    // Objects drawn since the last call
+    static unsigned int takeSubmitted()
+    {
+        return submitted.exchange(0);
+    }
+};
+
+std::atomic<unsigned int> Culling::culled(0);
+std::atomic<unsigned int> Culling::submitted(0);
+
+#endif // CULLING_HPP_INCLUDED
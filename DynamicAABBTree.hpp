@@ -0,0 +1,368 @@
+#ifndef DYNAMICAABBTREE_HPP_INCLUDED
+#define DYNAMICAABBTREE_HPP_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include "Shapes.hpp"
+
+// Bounding volume tree for moving objects. Every proxy keeps a box fattened by
+// "margin", so small moves don't touch the tree at all; only when the real
+// bounds leave the fat box the leaf is removed and inserted again.
+// Nodes live in one vector and are recycled through a free list.
+// Every proxy carries collision layer bits and inner nodes hold the union of
+// their children's, so a query with a layer mask skips whole subtrees.
+class DynamicAABBTree
+{
+public:
+    static constexpr int nullNode = -1;
+
+private:
+
+    struct Node
+    {
+        Rect<double> bounds;
+        void*   userData;
+        unsigned int layers;
+        int     parent;     // Next free node while on the free list
+        int     child1;
+        int     child2;
+        int     height;     // -1 for free nodes, 0 for leaves
+
+        Node()
+            : bounds(0, 0, 0, 0), userData(nullptr), layers(0), parent(nullNode), child1(nullNode), child2(nullNode), height(-1)
+        {}
+
+        bool isLeaf() const
+        {
+            return child1 == nullNode;
+        }
+    };
+
+    std::vector<Node>   nodes;
+    int                 root;
+    int                 freeList;
+    unsigned int        proxyCount;
+    double              margin;
+
+    static Rect<double> merge(const Rect<double>& a, const Rect<double>& b)
+    {
+        double left   = std::min(a.position.x, b.position.x);
+        double top    = std::min(a.position.y, b.position.y);
+        double right  = std::max(a.position.x + a.size.x, b.position.x + b.size.x);
+        double bottom = std::max(a.position.y + a.size.y, b.position.y + b.size.y);
+        return Rect<double>(left, top, right - left, bottom - top);
+    }
+
+    static double perimeter(const Rect<double>& a)
+    {
+        return 2 * (a.size.x + a.size.y);
+    }
+
+    static bool contains(const Rect<double>& outer, const Rect<double>& inner)
+    {
+        return  outer.position.x <= inner.position.x && outer.position.y <= inner.position.y &&
+                outer.position.x + outer.size.x >= inner.position.x + inner.size.x &&
+                outer.position.y + outer.size.y >= inner.position.y + inner.size.y;
+    }
+
+    static bool overlaps(const Rect<double>& a, const Rect<double>& b)
+    {
+        return  a.position.x <= b.position.x + b.size.x && b.position.x <= a.position.x + a.size.x &&
+                a.position.y <= b.position.y + b.size.y && b.position.y <= a.position.y + a.size.y;
+    }
+
+    int allocateNode()
+    {
+        if(freeList == nullNode)
+        {
+            nodes.push_back(Node());
+            nodes.back().height = 0;
+            return nodes.size() - 1;
+        }
+        int node = freeList;
+        freeList = nodes[node].parent;
+        nodes[node] = Node();
+        nodes[node].height = 0;
+        return node;
+    }
+
+    void freeNode(int node)
+    {
+        nodes[node].parent = freeList;
+        nodes[node].height = -1;
+        freeList = node;
+    }
+
+    void refit(int node)
+    {
+        while(node != nullNode)
+        {
+            Node& n = nodes[node];
+            n.bounds = merge(nodes[n.child1].bounds, nodes[n.child2].bounds);
+            n.height = 1 + std::max(nodes[n.child1].height, nodes[n.child2].height);
+            n.layers = nodes[n.child1].layers | nodes[n.child2].layers;
+            node = n.parent;
+        }
+    }
+
+    void insertLeaf(int leaf)
+    {
+        if(root == nullNode)
+        {
+            root = leaf;
+            nodes[leaf].parent = nullNode;
+            return;
+        }
+
+        // Walk down choosing the child whose bounds grow the least
+        const Rect<double> leafBounds = nodes[leaf].bounds;
+        int sibling = root;
+        while(!nodes[sibling].isLeaf())
+        {
+            const Node& n = nodes[sibling];
+            double cost   = 2 * perimeter(merge(n.bounds, leafBounds));
+            double inheritance = cost - 2 * perimeter(n.bounds);
+
+            double cost1 = perimeter(merge(nodes[n.child1].bounds, leafBounds)) + inheritance;
+            double cost2 = perimeter(merge(nodes[n.child2].bounds, leafBounds)) + inheritance;
+            if(!nodes[n.child1].isLeaf())
+                cost1 -= perimeter(nodes[n.child1].bounds);
+            if(!nodes[n.child2].isLeaf())
+                cost2 -= perimeter(nodes[n.child2].bounds);
+
+            if(cost < cost1 && cost < cost2)
+                break;
+            sibling = cost1 < cost2 ? n.child1 : n.child2;
+        }
+
+        int oldParent = nodes[sibling].parent;
+        int newParent = allocateNode();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        nodes[sibling].parent   = newParent;
+        nodes[leaf].parent      = newParent;
+
+        if(oldParent == nullNode)
+        {
+            root = newParent;
+        }
+        else if(nodes[oldParent].child1 == sibling)
+        {
+            nodes[oldParent].child1 = newParent;
+        }
+        else
+        {
+            nodes[oldParent].child2 = newParent;
+        }
+        refit(newParent);
+    }
+
+    void removeLeaf(int leaf)
+    {
+        if(leaf == root)
+        {
+            root = nullNode;
+            return;
+        }
+
+        int parent      = nodes[leaf].parent;
+        int grandParent = nodes[parent].parent;
+        int sibling     = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        if(grandParent == nullNode)
+        {
+            root = sibling;
+            nodes[sibling].parent = nullNode;
+        }
+        else
+        {
+            if(nodes[grandParent].child1 == parent)
+                nodes[grandParent].child1 = sibling;
+            else
+                nodes[grandParent].child2 = sibling;
+            nodes[sibling].parent = grandParent;
+            refit(grandParent);
+        }
+        freeNode(parent);
+    }
+
+    Rect<double> fatten(const Rect<double>& bounds) const
+    {
+        return Rect<double>(bounds.position - Vector2d(margin, margin), bounds.size + Vector2d(margin, margin) * 2.0);
+    }
+
+public:
+
+    // Returns the proxy id, valid until removeProxy
+    int createProxy(const Rect<double>& bounds, void* userData, unsigned int layers = ~0u)
+    {
+        int leaf = allocateNode();
+        nodes[leaf].bounds   = fatten(bounds);
+        nodes[leaf].userData = userData;
+        nodes[leaf].layers   = layers;
+        insertLeaf(leaf);
+        proxyCount++;
+        return leaf;
+    }
+
+    void removeProxy(int proxy)
+    {
+        removeLeaf(proxy);
+        freeNode(proxy);
+        proxyCount--;
+    }
+
+    // Returns true if the tree had to be changed
+    bool moveProxy(int proxy, const Rect<double>& bounds)
+    {
+        if(contains(nodes[proxy].bounds, bounds))
+        {
+            return false;
+        }
+        removeLeaf(proxy);
+        nodes[proxy].bounds = fatten(bounds);
+        insertLeaf(proxy);
+        return true;
+    }
+
+    void setProxyLayers(int proxy, unsigned int layers)
+    {
+        nodes[proxy].layers = layers;
+        refit(nodes[proxy].parent);
+    }
+    
+    unsigned int getProxyLayers(int proxy) const
+    {
+        return nodes[proxy].layers;
+    }
+
+    // Whether the proxy exists and still carries the user data, for callers
+    // holding on to an id that may have been removed and reused since
+    bool isProxy(int proxy, const void* userData) const
+    {
+        return proxy >= 0 && proxy < static_cast<int>(nodes.size()) && nodes[proxy].height == 0 && nodes[proxy].userData == userData;
+    }
+
+    void* getUserData(int proxy) const
+    {
+        return nodes[proxy].userData;
+    }
+
+    const Rect<double>& getFatBounds(int proxy) const
+    {
+        return nodes[proxy].bounds;
+    }
+
+    unsigned int getProxyCount() const
+    {
+        return proxyCount;
+    }
+
+    int getHeight() const
+    {
+        return root == nullNode ? 0 : nodes[root].height;
+    }
+
+    // handler(proxy) is called for every proxy whose fat box overlaps the area
+    // and whose layers are in the mask, it returns true to stop the query
+    template<class THandler>
+    bool query(const Rect<double>& area, THandler handler, unsigned int mask = ~0u) const
+    {
+        if(root == nullNode)
+        {
+            return false;
+        }
+        // Small trees never leave the inline stack, deeper ones spill to the heap
+        const unsigned int inlineDepth = 64;
+        int inlineStack[inlineDepth];
+        std::vector<int> heapStack;
+        unsigned int top = 0;
+        inlineStack[top++] = root;
+        while(top > 0 || !heapStack.empty())
+        {
+            int node;
+            if(!heapStack.empty())
+            {
+                node = heapStack.back();
+                heapStack.pop_back();
+            }
+            else
+            {
+                node = inlineStack[--top];
+            }
+            const Node& n = nodes[node];
+            if(!(n.layers & mask) || !overlaps(n.bounds, area))
+            {
+                continue;
+            }
+            if(n.isLeaf())
+            {
+                if(handler(node))
+                {
+                    return true;
+                }
+            }
+            else if(top + 2 <= inlineDepth)
+            {
+                inlineStack[top++] = n.child1;
+                inlineStack[top++] = n.child2;
+            }
+            else
+            {
+                heapStack.push_back(n.child1);
+                heapStack.push_back(n.child2);
+            }
+        }
+        return false;
+    }
+
+    // handler(proxy1, proxy2) once for every pair of proxies with overlapping fat boxes
+    template<class THandler>
+    void queryPairs(THandler handler) const
+    {
+        for(unsigned int i=0; i<nodes.size(); i++)
+        {
+            if(nodes[i].height != 0)
+            {
+                continue;
+            }
+            int proxy = i;
+            query(nodes[proxy].bounds, [&](int other)
+            {
+                if(other > proxy)
+                {
+                    handler(proxy, other);
+                }
+                return false;
+            });
+        }
+    }
+
+    // handler(proxy1, proxy2) for every overlapping pair with one proxy from each tree
+    template<class THandler>
+    void queryPairs(const DynamicAABBTree& other, THandler handler) const
+    {
+        for(unsigned int i=0; i<nodes.size(); i++)
+        {
+            if(nodes[i].height != 0)
+            {
+                continue;
+            }
+            int proxy = i;
+            other.query(nodes[proxy].bounds, [&](int otherProxy)
+            {
+                handler(proxy, otherProxy);
+                return false;
+            });
+        }
+    }
+
+    DynamicAABBTree(double margin_ = 4)
+        : root(nullNode), freeList(nullNode), proxyCount(0), margin(margin_)
+    {}
+};
+
+constexpr int DynamicAABBTree::nullNode;
+
+#endif // DYNAMICAABBTREE_HPP_INCLUDED
@@ -0,0 +1,227 @@
+#ifndef JOBSYSTEM_HPP_INCLUDED
+#define JOBSYSTEM_HPP_INCLUDED
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include "CommandBuffer.hpp"
+
+// Thread pool with one job queue per thread. A thread takes its newest job
+// first and, when out of work, steals the oldest job of another thread.
+// The first slots belong to threads outside the pool submitting work (slot 0
+// to the main thread, others taken with attachThread), which help running
+// jobs while they wait for them. Any thread may run any queued job, so work
+// that must not delay another submitter, like the render thread's, goes to
+// a JobSystem of its own.
+// Every slot has its own CommandBuffer, current while that thread runs a job.
+// flushCommandBuffers merges them by the order given to the jobs, keeping the
+// order each job recorded its commands in, so the result doesn't depend on
+// which thread ran or stole which job. parallelFor orders its chunks by their
+// position; jobs submitted with the same order are applied in slot order.
+class JobSystem
+{
+    struct Job
+    {
+        std::function<void()>       function;
+        std::atomic<unsigned int>*  counter;
+        unsigned int                order;
+    };
+
+    struct Queue
+    {
+        std::deque<Job> jobs;
+        std::mutex      mutex;
+    };
+
+    std::vector<std::unique_ptr<Queue> >    queues;
+    std::vector<CommandBuffer>              commandBuffers;
+    std::vector<CommandBuffer::Command>     mergedCommands;
+    std::vector<std::thread>                threads;
+
+    std::mutex                  sleepMutex;
+    std::condition_variable     wakeUp;
+    std::atomic<unsigned int>   queuedJobs;
+    std::atomic<bool>           running;
+
+    static thread_local unsigned int threadSlot;
+
+    bool popJob(unsigned int slot, Job& job)
+    {
+        {
+            Queue& own = *queues[slot];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if(!own.jobs.empty())
+            {
+                job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                queuedJobs--;
+                return true;
+            }
+        }
+        for(unsigned int i=1; i<queues.size(); i++)
+        {
+            Queue& other = *queues[(slot + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(other.mutex);
+            if(!other.jobs.empty())
+            {
+                job = std::move(other.jobs.front());
+                other.jobs.pop_front();
+                queuedJobs--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool runOneJob(unsigned int slot)
+    {
+        Job job;
+        if(!popJob(slot, job))
+        {
+            return false;
+        }
+        {
+            CommandBuffer::Scope scope(commandBuffers[slot], job.order);
+            job.function();
+        }
+        (*job.counter)--;
+        return true;
+    }
+
+    void workerLoop(unsigned int slot)
+    {
+        threadSlot = slot;
+        while(running)
+        {
+            if(runOneJob(slot))
+            {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wakeUp.wait(lock, [this]{return !running || queuedJobs > 0;});
+        }
+    }
+
+public:
+
+    unsigned int getThreadCount() const
+    {
+        return threads.size() + 1;
+    }
+
+    // counter is increased now and decreased once the job is done; order
+    // places the job's commands among the others when they are flushed
+    void submit(const std::function<void()>& function, std::atomic<unsigned int>& counter, unsigned int order = 0)
+    {
+        counter++;
+        {
+            Queue& queue = *queues[threadSlot];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(Job{function, &counter, order});
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            queuedJobs++;
+        }
+        wakeUp.notify_one();
+    }
+
+    // Runs one queued job on the calling thread, returns false if there was none
+    bool runPendingJob()
+    {
+        return runOneJob(threadSlot);
+    }
+
+    // Runs other jobs until the counter drops to zero
+    void wait(std::atomic<unsigned int>& counter)
+    {
+        while(counter > 0)
+        {
+            if(!runOneJob(threadSlot))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Calls function(begin, end) for consecutive chunks of [0, count) in parallel
+    // and returns when all of them are done
+    template<class TFunction>
+    void parallelFor(unsigned int count, unsigned int chunkSize, TFunction function)
+    {
+        std::atomic<unsigned int> counter(0);
+        chunkSize = std::max(chunkSize, 1u);
+        for(unsigned int begin = 0; begin < count; begin += chunkSize)
+        {
+            unsigned int end = std::min(begin + chunkSize, count);
+            submit([&function, begin, end]{function(begin, end);}, counter, begin);
+        }
+        wait(counter);
+    }
+
+    // The sync point for the commands recorded by finished jobs
+    void flushCommandBuffers()
+    {
+        for(CommandBuffer& buffer : commandBuffers)
+        {
+            buffer.takeCommands(mergedCommands);
+        }
+        std::stable_sort(mergedCommands.begin(), mergedCommands.end(), [](const CommandBuffer::Command& a, const CommandBuffer::Command& b)
+        {
+            return a.order < b.order;
+        });
+        for(CommandBuffer::Command& command : mergedCommands)
+        {
+            command.function();
+        }
+        mergedCommands.clear();
+    }
+
+    // Gives the calling thread its own slot, has to be below externalSlots.
+    // Threads that never attach share slot 0, so only one of them may use the system.
+    void attachThread(unsigned int slot)
+    {
+        threadSlot = slot;
+    }
+
+    // By default one thread per core, the main thread included
+    JobSystem(unsigned int threadCount = std::max(std::thread::hardware_concurrency(), 1u), unsigned int externalSlots = 1)
+        : commandBuffers(std::max(threadCount, 1u) - 1 + std::max(externalSlots, 1u)), queuedJobs(0), running(true)
+    {
+        externalSlots = std::max(externalSlots, 1u);
+        unsigned int slots = std::max(threadCount, 1u) - 1 + externalSlots;
+        for(unsigned int i=0; i<slots; i++)
+        {
+            queues.emplace_back(new Queue);
+        }
+        for(unsigned int i=externalSlots; i<slots; i++)
+        {
+            threads.emplace_back(&JobSystem::workerLoop, this, i);
+        }
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            running = false;
+        }
+        wakeUp.notify_all();
+        for(std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+};
+
+thread_local unsigned int JobSystem::threadSlot = 0;
+
+JobSystem jobSystem;
+
+#endif // JOBSYSTEM_HPP_INCLUDED
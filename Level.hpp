@@ -2,12 +2,36 @@
 #define LEVEL_HPP_INCLUDED
 #include <vector>
 #include "Object.hpp"
+#include "SlotMap.hpp"
+#include "Arena.hpp"
 
+// Actors are reached through the handles spawn returns; a handle to a
+// despawned actor is stale and finds nothing, even if its slot was reused.
+// Every actor remembers its own handle, so it is spawned at most once and
+// belongs to one level.
+// Actors made with create() live in the level's arena, which is freed in
+// one go by unload().
 class Level
 {
+	Arena						arena;
+	
+	void destroy(Actor* actor)
+	{
+		if(arena.owns(actor))
+		{
+			actor->~Actor();
+		}
+		else
+		{
+			delete actor;
+		}
+	}
+	
 public:
 	
-	std::vector<Actor*> 		actors;
+	typedef SlotMap<Actor>::Handle Handle;
+	
+	SlotMap<Actor> 				actors;
 	
 	void update(double deltaTime)
 	{
@@ -24,51 +48,70 @@ public:
 		}
 	}
 	
-	std::vector<Actor*>::const_iterator getActor(Actor* ptr)
+	// nullptr for a stale handle
+	Actor* getActor(const Handle& handle) const
 	{
-		if(!ptr)
-		{
-			return actors.end();
-		}
-		for(auto it = actors.begin(); it < actors.end(); it++)
-		{
-			if(*it == ptr)
-			{
-				return it;
-			}
-		}
-		return actors.end();
+		return actors.get(handle);
+	}
+	bool contains(const Handle& handle) const
+	{
+		return actors.contains(handle);
 	}
-	bool contains(Actor* ptr)
+	bool contains(const Actor& actor) const
 	{
-		if(!ptr)
+		return actors.get(actor.levelHandle) == &actor;
+	}
+	// Stale unless the actor is spawned in this level
+	Handle getHandle(const Actor& actor) const
+	{
+		return actor.levelHandle;
+	}
+	
+	// Returns a null handle if the actor is already spawned; the level then
+	// doesn't take it over
+	Handle spawn(Actor* ptr)
+	{
+		if(!ptr || contains(*ptr))
 		{
-			return false;
+			return Handle();
 		}
-		return getActor(ptr) == actors.end();
+		ptr->levelHandle = actors.insert(ptr);
+		return ptr->levelHandle;
 	}
 	
-	bool spawn(Actor* ptr)
+	template<class T, class... TArgs>
+	Handle create(TArgs&&... args)
 	{
-		if(contains(ptr))
+		return spawn(arena.create<T>(std::forward<TArgs>(args)...));
+	}
+	
+	bool despawn(const Handle& handle)
+	{
+		Actor* actor = actors.get(handle);
+		if(!actor)
 		{
 			return false;
 		}
-		actors.push_back(ptr);
+		actors.erase(handle);
+		destroy(actor);
 		return true;
 	}
 	
-	bool despawn(Actor* ptr)
+	// Despawns everything; the memory of the created actors is freed at once
+	void unload()
 	{
-		auto it = getActor(ptr);
-		if(it == actors.end())
+		for(Actor* actor : actors)
 		{
-			return false;
+			destroy(actor);
 		}
-		delete *it;
-		actors.erase(it);
-		return true;
-	}	
+		actors.clear();
+		arena.reset();
+	}
+	
+	~Level()
+	{
+		unload();
+	}
 };
 
 #endif // LEVEL_HPP_INCLUDED
@@ -12,9 +12,73 @@ protected:
     
     virtual void emitLightOn(sf::RenderTexture* tempLightmapTexture = defaultTempLightmapTexture) = 0;
     
+    // Geometry only, no drawing, so it can be prepared away from the window's thread
+    virtual void buildShadows() = 0;
+    
+    Vector2d previousPosition;
+    bool     hasPreviousPosition = false;
     
 public:
     
+    // Same as Actor::savePreviousState, for lights attached to moving actors
+    void savePreviousState()
+    {
+        previousPosition    = getPosition();
+        hasPreviousPosition = true;
+    }
+    
+    Vector2d getMotion() const
+    {
+        return hasPreviousPosition ? getPosition() - previousPosition : Vectors::null;
+    }
+    
+    virtual void capture(RenderSnapshot& /*snapshot*/) const
+    {
+        return;
+    }
+    
+    static void savePreviousStates()
+    {
+        iterate([](LightEmitter& le)
+        {
+            le.savePreviousState();
+            return false;
+        });
+    }
+    
+    static void captureAll(RenderSnapshot& snapshot)
+    {
+        iterate([&snapshot](const LightEmitter& le)
+        {
+            le.capture(snapshot);
+            return false;
+        });
+    }
+    
+    // A texture can be drawn to from one thread at a time; the thread handing
+    // them over releases them first
+    static void setTexturesActive(bool active)
+    {
+        if(defaultLightmapTexture)
+        {
+            defaultLightmapTexture->setActive(active);
+        }
+        if(defaultTempLightmapTexture)
+        {
+            defaultTempLightmapTexture->setActive(active);
+        }
+    }
+    
+    // Has to run after the emitters and platforms are in their final place for the frame
+    static void buildAllShadows()
+    {
+        iterate([](LightEmitter& le)
+        {
+            le.buildShadows();
+            return false;
+        });
+    }
+    
     static void generateLightMap(sf::RenderTexture* lightmapTexture = defaultLightmapTexture, sf::RenderTexture* tempLightmapTexture = defaultTempLightmapTexture)
     {
         if(!lightmapTexture || !tempLightmapTexture)
@@ -40,7 +104,8 @@ public:
         target.draw(sf::Sprite(lightmapTexture->getTexture()), sf::RenderStates(sf::BlendMultiply));
     }
     
-    static void generateAndApplyLightMap(sf::RenderTarget& target, sf::RenderTexture* lightmapTexture = defaultLightmapTexture, sf::RenderTexture* tempLightmapTexture = defaultTempLightmapTexture)
+    // Expects the shadows to be built already
+    static void renderLightMap(sf::RenderTexture* lightmapTexture = defaultLightmapTexture, sf::RenderTexture* tempLightmapTexture = defaultTempLightmapTexture)
     {
         if(!lightmapTexture || !tempLightmapTexture)
         {
@@ -48,6 +113,16 @@ public:
         }
         generateLightMap(lightmapTexture, tempLightmapTexture);
         lightmapTexture->display();
+    }
+    
+    static void generateAndApplyLightMap(sf::RenderTarget& target, sf::RenderTexture* lightmapTexture = defaultLightmapTexture, sf::RenderTexture* tempLightmapTexture = defaultTempLightmapTexture)
+    {
+        if(!lightmapTexture || !tempLightmapTexture)
+        {
+            return;
+        }
+        buildAllShadows();
+        renderLightMap(lightmapTexture, tempLightmapTexture);
         applyLightMap(target, lightmapTexture);
     }
     
@@ -91,35 +166,87 @@ class PointLightEmitter : public LightEmitter
 {
     sf::CircleShape shape;
     
-    void mapPlatformsShadows(sf::RenderTexture* tempLightmapTexture)
+    // Shadows of all platforms in range, drawn in one call
+    sf::VertexArray shadows;
+    
+public:
+    
+    // Only reads the platforms, so it is safe to call from any thread
+    static void mapPlatformsShadows(const Vector2d& position, double radius, sf::VertexArray& shadows)
     {
-        sf::VertexArray shadow(sf::PrimitiveType::TriangleStrip, 5);
+        shadows.clear();
+        shadows.setPrimitiveType(sf::PrimitiveType::Triangles);
         
-        shadow[0].color = sf::Color::Black;
-        shadow[1].color = sf::Color::Black;
-        shadow[2].color = sf::Color::Black;
-        shadow[3].color = sf::Color::Black;
-        shadow[4].color = sf::Color::Black;
+        // Strip of 5 points per platform, stored as the 3 triangles it is made of
+        sf::Vertex shadow[5];
         
-        double radius2_2 = getRadius() * getRadius() * 4;
+        double radius2_2 = radius * radius * 4;
         
-        for(Platform& platform : platforms)
+        auto mapShadow = [&](const Platform& platform)
         {
             shadow[0].position = platform.collider.position;
             shadow[2].position = platform.collider.getEnd();
             
-            Vector2d sourceToPoint1 = platform.collider.position - getPosition();
-            Vector2d sourceToPoint2 = platform.collider.getEnd() - getPosition();
-            Vector2d sourceToPoint3 = (platform.collider.getCenter() - getPosition());
+            Vector2d sourceToPoint1 = platform.collider.position - position;
+            Vector2d sourceToPoint2 = platform.collider.getEnd() - position;
+            Vector2d sourceToPoint3 = (platform.collider.getCenter() - position);
             
-            shadow[1].position = getPosition() + (sourceToPoint1.magnatudeSquared() <  radius2_2 ? sourceToPoint1.resize(getRadius()*2) : sourceToPoint1);
-            shadow[4].position = getPosition() + (sourceToPoint2.magnatudeSquared() <  radius2_2 ? sourceToPoint2.resize(getRadius()*2) : sourceToPoint2);
+            shadow[1].position = position + (sourceToPoint1.magnatudeSquared() <  radius2_2 ? sourceToPoint1.resize(radius*2) : sourceToPoint1);
+            shadow[4].position = position + (sourceToPoint2.magnatudeSquared() <  radius2_2 ? sourceToPoint2.resize(radius*2) : sourceToPoint2);
             
-            shadow[3].position = getPosition() + (sourceToPoint3.magnatudeSquared() <  radius2_2 ? sourceToPoint3.resize(getRadius()*2) : sourceToPoint3);
+            shadow[3].position = position + (sourceToPoint3.magnatudeSquared() <  radius2_2 ? sourceToPoint3.resize(radius*2) : sourceToPoint3);
             
-            tempLightmapTexture->draw(shadow);
+            for(unsigned int i=0; i<3; i++)
+            {
+                shadows.append(shadow[i]);
+                shadows.append(shadow[i+1]);
+                shadows.append(shadow[i+2]);
+            }
+        };
+        
+        // Light is only drawn within the radius, so platforms further away cast nothing visible
+        if(platformBVH.isBuilt())
+        {
+            platformBVH.queryRadius(position, radius, [&](unsigned int index)
+            {
+                mapShadow(platforms[index]);
+                return false;
+            });
+            return;
+        }
+        for(const Platform& platform : platforms)
+        {
+            mapShadow(platform);
+        }
+    }
+    
+    // Light map of the snapshot lights, shadows[i] built for lights[i] at the
+    // same interpolation
+    static void renderLightMap(const std::vector<RenderSnapshot::LightState>& lights, const std::vector<sf::VertexArray>& shadows, double interpolation,
+                               sf::RenderTexture* lightmapTexture = defaultLightmapTexture, sf::RenderTexture* tempLightmapTexture = defaultTempLightmapTexture)
+    {
+        if(!lightmapTexture || !tempLightmapTexture)
+        {
+            return;
+        }
+        sf::CircleShape shape;
+        shape.setFillColor(sf::Color::White);
+        lightmapTexture->clear();
+        for(unsigned int i=0; i<lights.size() && i<shadows.size(); i++)
+        {
+            const RenderSnapshot::LightState& light = lights[i];
+            shape.setRadius(light.radius);
+            shape.setOrigin(light.radius, light.radius);
+            shape.setPosition(RenderSnapshot::interpolate(light.position, light.motion, interpolation));
+            tempLightmapTexture->clear();
+            tempLightmapTexture->draw(shape);
+            tempLightmapTexture->draw(shadows[i]);
+            tempLightmapTexture->display();
+            lightmapTexture->draw(sf::Sprite(tempLightmapTexture->getTexture()));
         }
+        lightmapTexture->display();
     }
+    
 protected:    
     
     
@@ -135,12 +262,21 @@ protected:
         shape.setScale(getScale());
         tempLightmapTexture->clear();
         tempLightmapTexture->draw(shape);
-        
-        mapPlatformsShadows(tempLightmapTexture);
+        tempLightmapTexture->draw(shadows);
+    }
+    
+    virtual void buildShadows()
+    {
+        mapPlatformsShadows(getPosition(), getRadius(), shadows);
     }
 public:
     
-    double getRadius()
+    virtual void capture(RenderSnapshot& snapshot) const
+    {
+        snapshot.addLight(getPosition(), getMotion(), getRadius());
+    }
+    
+    double getRadius() const
     {
         return shape.getRadius();
     }
@@ -151,6 +287,7 @@ public:
     }
     
     PointLightEmitter(double radius)
+        : shadows(sf::PrimitiveType::Triangles)
     {
         setRadius(radius);
         shape.setFillColor(sf::Color::White);
@@ -2,12 +2,20 @@
 #define OBJECT_HPP_INCLUDED
 
 #include <typeinfo>
+#include <atomic>
+#include <algorithm>
 #include "Vectors.hpp"
 #include "TextureManager.hpp"
 #include "Animations.hpp"
 #include "Colisions.hpp"
 #include "Shapes.hpp"
 #include "PLatform.hpp"
+#include "PlatformGrid.hpp"
+#include "DynamicAABBTree.hpp"
+#include "JobSystem.hpp"
+#include "RenderSnapshot.hpp"
+#include "SlotMap.hpp"
+#include "SpriteBatch.hpp"
 
 Vector2d globalGravity 	= Vectors::up;
 double 	 globalDrag		= 1;
@@ -20,10 +28,44 @@ protected:
         if(collider)
         {
             collider->updateCollider(getPosition(), getScale(), getRotation());
+            if(proxyTree)
+            {
+                // The tree is shared, so inside a job the move waits for the sync
+                // point. The actor may be gone by then, so the command only keeps
+                // what it needs and moves the proxy only if it is still the actor's.
+                DynamicAABBTree* tree   = proxyTree;
+                const int        proxy  = proxyId;
+                const void*      owner  = this;
+                Rect<double>     bounds = collider->getBoundingRect();
+                CommandBuffer::defer([tree, proxy, owner, bounds]
+                {
+                    if(tree->isProxy(proxy, owner))
+                    {
+                        tree->moveProxy(proxy, bounds);
+                    }
+                });
+            }
         }
     }
     
     Actor* parent = nullptr;
+    
+    DynamicAABBTree* proxyTree = nullptr;
+    int              proxyId   = DynamicAABBTree::nullNode;
+    
+    // Kept by the actor, so they survive replacing the collider
+    unsigned int     collisionLayer = CollisionLayers::Default;
+    unsigned int     collisionMask  = CollisionLayers::All;
+    
+    Vector2d         previousPosition;
+    double           previousRotation = 0;
+    bool             hasPreviousPosition = false;
+    
+    // Set by the Level the actor is spawned in; copies start unspawned
+    friend class Level;
+    SlotMap<Actor>::Handle levelHandle;
+    
+    static std::atomic<unsigned int> substepCount;
 public:
 	Collider* 	collider;
 	
@@ -48,6 +90,8 @@ public:
 	    updateSubstepKinematics(deltaTime, maxShift, handler, step);
 	}
 	
+	// Substeps are at most maxShift long, or as long as the free space around
+	// the actor allows (see getClearance), so only actors near walls subdivide
 	template<class THandler>
 	void updateSubstepKinematics(double deltaTime, double maxShift, THandler handler, const Vector2d& step = Vectors::null)
 	{
@@ -62,7 +106,9 @@ public:
             fullShift    = newVelocity * newDeltaTime + newStep;
             if(fullShift.magnatudeSquared() == 0)
                 break;
-            sub          = std::ceil(fullShift.magnatude() / maxShift);
+            double shiftLength = fullShift.magnatude();
+            sub          = std::ceil(shiftLength / std::max(maxShift, getClearance(shiftLength)));
+            substepCount++;
             subDeltaTime = newDeltaTime / sub;
             subShift     = fullShift    / sub;
             
@@ -78,6 +124,22 @@ public:
         }while(sub > 1);
 	}
 	
+	// Distance to the closest platform the actor collides with, up to maxDistance
+	double getClearance(double maxDistance) const
+	{
+	    if(!collider || !platformGrid.isBuilt())
+        {
+            return 0;
+        }
+        return platformGrid.getClearance(collider->getBoundingRect(), maxDistance, collisionMask);
+	}
+	
+	// Substeps taken by all actors since the last call
+	static unsigned int takeSubstepCount()
+	{
+	    return substepCount.exchange(0);
+	}
+	
 	virtual void update(double deltaTime)
 	{
 		return;
@@ -88,6 +150,64 @@ public:
 		return;
 	}
 	
+	// Called before every simulation step, so frames drawn between two steps
+	// can place the actor in between them
+	void savePreviousState()
+	{
+	    previousPosition    = getPosition();
+	    previousRotation    = getRotation();
+	    hasPreviousPosition = true;
+	}
+	
+	// Movement during the last simulation step
+	Vector2d getMotion() const
+	{
+	    if(!hasPreviousPosition)
+        {
+            return Vectors::null;
+        }
+	    return getPosition() - previousPosition;
+	}
+	
+	// Rotation during the last simulation step, in degrees
+	double getTurn() const
+	{
+	    if(!hasPreviousPosition)
+        {
+            return 0;
+        }
+	    return RenderSnapshot::getTurn(previousRotation, getRotation());
+	}
+	
+	Vector2d getInterpolatedPosition(double interpolation) const
+	{
+	    return RenderSnapshot::interpolate(getPosition(), getMotion(), interpolation);
+	}
+	
+	// Adds whatever draw() would draw to the batch, moved by offset and
+	// turned by rotation degrees around the actor's position
+	virtual void addToBatch(SpriteBatch& /*batch*/, const Vector2d& /*offset*/ = Vectors::null, double /*rotation*/ = 0) const
+	{
+	    return;
+	}
+	
+	// Copies whatever draw() would draw into the snapshot
+	virtual void capture(RenderSnapshot& /*snapshot*/) const
+	{
+	    return;
+	}
+	
+	// States moving and turning the actor from its current transform to the interpolated one
+	sf::RenderStates getInterpolatedStates(const sf::RenderStates& states, double interpolation) const
+	{
+	    sf::RenderStates interpolated(states);
+	    const Vector2d position = getPosition();
+	    const Vector2d offset   = getInterpolatedPosition(interpolation) - position;
+	    interpolated.transform.translate(offset.x, offset.y);
+	    interpolated.transform.rotate(getTurn() * (interpolation - 1), position.x, position.y);
+	    return interpolated;
+	}
+	
 	Collision::Result testCollision(const Collider& collider_) const
 	{
 		if(collider)
@@ -121,10 +241,38 @@ public:
             delete collider;
         }
         collider = new ShapeCollider<T>(shape);
+        collider->setLayer(collisionLayer);
+        collider->setMask(collisionMask);
+        updateCollider();
+    }
+    
+    void setCollisionLayers(unsigned int layer, unsigned int mask = CollisionLayers::All)
+    {
+        collisionLayer = layer;
+        collisionMask  = mask;
+        if(collider)
+        {
+            collider->setLayer(layer);
+            collider->setMask(mask);
+        }
+        if(proxyTree)
+        {
+            proxyTree->setProxyLayers(proxyId, layer);
+        }
+    }
+    
+    unsigned int getCollisionLayer() const
+    {
+        return collisionLayer;
+    }
+    unsigned int getCollisionMask() const
+    {
+        return collisionMask;
     }
     
     void removeCollider()
     {
+        unregisterProxy();
         if(collider)
         {
             delete collider;
@@ -132,35 +280,70 @@ public:
         }
     }
     
+    // The actor keeps its proxy in the tree up to date on every collider update.
+    // The tree stores the actor itself as user data.
+    void registerProxy(DynamicAABBTree& tree)
+    {
+        unregisterProxy();
+        if(collider)
+        {
+            proxyTree = &tree;
+            proxyId   = tree.createProxy(collider->getBoundingRect(), this, collisionLayer);
+        }
+    }
+    
+    void unregisterProxy()
+    {
+        if(proxyTree)
+        {
+            proxyTree->removeProxy(proxyId);
+            proxyTree = nullptr;
+            proxyId   = DynamicAABBTree::nullNode;
+        }
+    }
+    
+    Vector2d resolveWallCollision(Collision::Result& result, Platform& platform)
+    {
+        if(platform.collider.isVertical)
+        {
+            velocity.x = 0;
+        }
+        else
+        {
+            velocity.y = 0;
+        }
+        return moveOutOfWall(result, *this);
+    }
+    
     Vector2d moveOutOfWalls(std::vector<Platform>& platforms)
     {
     	Vector2d shift(0,0);
     	handleAllCollisions(*this, platforms.begin(), platforms.end(), [&shift](Collision::Result& result, Actor& actor, Platform& platform)
         {
-            if(platform.collider.isVertical)
-			{
-                
-				if(std::abs(result.) <= 1)
-                {
-					//return;
-                }
-				actor.velocity.x = 0;
-                //std::cout << result.getPenetrationVector() << std::endl;
-			}
-			else
-			{
-				if(std::abs(result.distance) <= 1)
-                {
-					//return;
-                }
-				actor.velocity.y = 0;
-                //std::cout << result.getPenetrationVector() << std::endl;
-			}
-            shift += moveOutOfWall(result, actor);
+            shift += actor.resolveWallCollision(result, platform);
         });
         return shift;
     }
     
+    // Same as above, but tests only the platforms sharing a grid cell with the collider bounds
+    Vector2d moveOutOfWalls(std::vector<Platform>& platforms, const PlatformGrid& grid)
+    {
+        if(!collider || !grid.isBuilt())
+        {
+            return moveOutOfWalls(platforms);
+        }
+        
+    	Vector2d shift(0,0);
+    	grid.iterate(collider->getBoundingRect(), [&](unsigned int index)
+        {
+            handleCollision(*this, platforms[index], [&shift](Collision::Result& result, Actor& actor, Platform& platform)
+            {
+                shift += actor.resolveWallCollision(result, platform);
+            });
+        }, collisionMask);
+        return shift;
+    }
+    
 	Actor()
 		: 	collider(nullptr),
 			mass(0),
@@ -169,16 +352,21 @@ public:
 	}	
 	
 	Actor(Actor&& a) noexcept
-		: 	collider(a.collider),
+		: 	collisionLayer(a.collisionLayer),
+			collisionMask(a.collisionMask),
+			collider(a.collider),
 			mass(a.mass),
 			velocity(a.velocity)
 			
 	{
+		a.unregisterProxy();
 		a.collider = nullptr;
 	}
 	
 	Actor(const Actor& a) 
-		: 	collider(nullptr),
+		: 	collisionLayer(a.collisionLayer),
+			collisionMask(a.collisionMask),
+			collider(nullptr),
 			mass(a.mass),
 			velocity(a.velocity)
 			
@@ -196,6 +384,8 @@ public:
 	
 };
 
+std::atomic<unsigned int> Actor::substepCount(0);
+
 class SimpleActor : public Actor
 {
     Transform transform;
@@ -234,74 +424,226 @@ public:
 	virtual ~SimpleActor(){}
 };
 
+// The collections with queued spawns or despawns, applied together at the
+// end of every simulation step
+class CollectionQueues
+{
+    static std::vector<void(*)()> appliers;
+
+public:
+
+    static void add(void (*applier)())
+    {
+        appliers.push_back(applier);
+    }
+
+    // For appliers registered lazily, by the first queued change
+    static void addOnce(void (*applier)())
+    {
+        if(std::find(appliers.begin(), appliers.end(), applier) == appliers.end())
+        {
+            appliers.push_back(applier);
+        }
+    }
+
+    // Anything queued while applying waits for the next call
+    static void applyAll()
+    {
+        unsigned int count = appliers.size();
+        for(unsigned int i=0; i<count; i++)
+        {
+            appliers[i]();
+        }
+    }
+};
+
+std::vector<void(*)()> CollectionQueues::appliers;
+
+// Static registry of the spawned T, which has to derive from Collection<T>.
+// Every element remembers its own handle, so spawning, despawning and
+// looking up are O(1); despawning moves the last element into the gap.
 template<class T>
 class Collection
 {
+public:
+    
+    typedef typename SlotMap<T>::Handle Handle;
+    
 protected:
     
-    static std::vector<T*> list;
+    static SlotMap<T> list;
+    
+private:
+    
+    static std::vector<T*>      pendingSpawns;
+    static std::vector<Handle>  pendingDespawns;
+    
+    Handle collectionHandle;
+    
 public:
     
-    static bool spawn(T* element)
+    // Returns a null handle if the element is already spawned
+    static Handle spawn(T* element)
     {
         //std::cout << "Spawned " << typeid(T).name() << std::endl;
-        for(auto it = list.begin(); it < list.end(); it++)
+        if(!element || contains(*element))
         {
-            if(*it == element)
-            {
-                return false;
-            }
+            return Handle();
         }
-        list.push_back(element);
-        return true;
+        Collection<T>& entry = *element;
+        entry.collectionHandle = list.insert(element);
+        return entry.collectionHandle;
     }
     
     static bool despawn(T* element)
     {
-        for(auto it = list.begin(); it < list.end(); it++)
+        return element && despawn(getHandle(*element));
+    }
+    
+    static bool despawn(const Handle& handle)
+    {
+        T* element = list.get(handle);
+        if(!element)
         {
-            if(*it == element)
-            {
-                delete *it;
-                list.erase(it);
-                return true;
-            }
+            return false;
         }
-        return false;
+        list.erase(handle);
+        delete element;
+        return true;
     }
     
     static void despawnAll()
     {
-        for(auto it = list.begin(); it != list.end(); it++)
+        for(T* element : list)
         {
-            delete *it;
+            delete element;
+        }
+        list.clear();
+    }
+    
+    // nullptr once the element was despawned
+    static T* get(const Handle& handle)
+    {
+        return list.get(handle);
+    }
+    
+    static bool contains(const T& element)
+    {
+        return list.get(getHandle(element)) == &element;
+    }
+    
+    static Handle getHandle(const T& element)
+    {
+        return static_cast<const Collection<T>&>(element).collectionHandle;
+    }
+    
+    // Spawning and despawning while the collection is iterated or updated
+    // (also from jobs) has to be queued; CollectionQueues::applyAll does it.
+    static void queueSpawn(T* element)
+    {
+        CommandBuffer::defer([element]
+        {
+            CollectionQueues::addOnce(&applyQueued);
+            pendingSpawns.push_back(element);
+        });
+    }
+    
+    // A handle queued twice is despawned once, the second time it is stale
+    static void queueDespawn(const Handle& handle)
+    {
+        CommandBuffer::defer([handle]
+        {
+            CollectionQueues::addOnce(&applyQueued);
+            pendingDespawns.push_back(handle);
+        });
+    }
+    
+    static void queueDespawn(T* element)
+    {
+        if(element)
+        {
+            queueDespawn(getHandle(*element));
+        }
+    }
+    
+    // Goes through T, so types wrapping spawn and despawn see the queued ones too
+    static void applyQueued()
+    {
+        std::vector<Handle> despawns;
+        std::vector<T*>     spawns;
+        despawns.swap(pendingDespawns);
+        spawns.swap(pendingSpawns);
+        for(const Handle& handle : despawns)
+        {
+            T::despawn(handle);
+        }
+        for(T* element : spawns)
+        {
+            T::spawn(element);
         }
-        list.erase(list.begin(), list.end());
     }
     
     template<class Thandler>
     static void iterate(Thandler handler)
     {
         bool end = false;
-        for(auto it = list.begin(); it != list.end() && !end; it++)
+        for(unsigned int i = 0; i < list.size() && !end; i++)
         {
-            end = handler(*(*it));
+            end = handler(*list[i]);
         }
     }
+    
+    // A copy isn't spawned just because the original is
+    Collection()
+    {}
+    Collection(const Collection<T>&)
+    {}
+    Collection<T>& operator=(const Collection<T>&)
+    {
+        return *this;
+    }
 };
 
 template<class T>
-std::vector<T*> Collection<T>::list;
+SlotMap<T> Collection<T>::list;
+
+template<class T>
+std::vector<T*> Collection<T>::pendingSpawns;
+
+template<class T>
+std::vector<typename Collection<T>::Handle> Collection<T>::pendingDespawns;
 
 template<class T>
 class ActorCollection : public Collection<T>
 {
 public:
-    static void drawAll(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default)
+    // Actors drawn with sprites go to the batch, to be drawn by its next flush
+    static void drawAll(SpriteBatch& batch, double interpolation = 1)
+    {
+        for(auto actor : Collection<T>::list)
+        {
+            actor->addToBatch(batch, actor->getInterpolatedPosition(interpolation) - actor->getPosition(), actor->getTurn() * (interpolation - 1));
+        }
+    }
+    static void drawAll(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default, double interpolation = 1)
+    {
+        for(auto actor : Collection<T>::list)
+        {
+            actor->draw(target, actor->getInterpolatedStates(states, interpolation));
+        }
+    }
+    static void savePreviousStates()
+    {
+        for(auto actor : Collection<T>::list)
+        {
+            actor->savePreviousState();
+        }
+    }
+    static void captureAll(RenderSnapshot& snapshot)
     {
         for(auto actor : Collection<T>::list)
         {
-            actor->draw(target, states);
+            actor->capture(snapshot);
         }
     }
     static void updateAll(double deltaTime)
@@ -311,45 +653,119 @@ public:
             actor->update(deltaTime);
         }
     }
+    // Updates run in chunks on the job system. Anything an update changes
+    // besides the actor itself has to go through CommandBuffer::defer;
+    // those changes are applied in order before this returns.
+    static void updateAllParallel(double deltaTime, JobSystem& jobs = jobSystem, unsigned int chunkSize = 64)
+    {
+        const SlotMap<T>& actors = Collection<T>::list;
+        jobs.parallelFor(actors.size(), chunkSize, [&actors, deltaTime](unsigned int begin, unsigned int end)
+        {
+            for(unsigned int i = begin; i < end; i++)
+            {
+                actors[i]->update(deltaTime);
+            }
+        });
+        jobs.flushCommandBuffers();
+    }
 };
 
-class SpriteActor : public Actor
-{	
+// Actor drawn as a TSprite. The transform lives in the actor, in doubles;
+// the sprite only gets it, as floats, when it is drawn or captured, so
+// moving the actor during substeps doesn't touch SFML at all.
+template<class TSprite>
+class SpriteTransformActor : public Actor
+{
+    Transform       transform;
+    mutable bool    isSpriteSynced = false;
+    
+protected:
+    
+    // Its own transform is overwritten from the actor's, so it is only
+    // reachable through accessors that leave the transform alone
+    mutable TSprite sprite;
+    
+    // Pushes the transform to the sprite if it changed since the last push
+    void syncSprite() const
+    {
+        if(!isSpriteSynced)
+        {
+            sprite.setPosition(transform.position);
+            sprite.setRotation(transform.rotation);
+            sprite.setScale(transform.scale);
+            isSpriteSynced = true;
+        }
+    }
+    
 public:
-		
-	sf::Sprite sprite;
-	
+    
 	// Transformable
 	virtual void setPosition (const Vector2d& 	position)
 	{
-		sprite.setPosition(position);
+		transform.position = position;
+		isSpriteSynced     = false;
 		updateCollider();
 	}
 	virtual void setScale	 (const Vector2d&	scale)
 	{
-		sprite.setScale(scale);
+		transform.scale = scale;
+		isSpriteSynced  = false;
 		updateCollider();
 	}
 	virtual void setRotation (double 			rotation)
 	{
-		sprite.setRotation(rotation);
+		transform.rotation = rotation;
+		isSpriteSynced     = false;
 		updateCollider();
 	}
 	
 	virtual Vector2d getPosition() 	const
 	{
-		return sprite.getPosition();
+		return transform.position;
 	}
 	virtual Vector2d getScale() 	const
 	{
-		return sprite.getScale();
+		return transform.scale;
 	}
 	virtual double	 getRotation()	const
 	{
-		return sprite.getRotation();
+		return transform.rotation;
 	}
 	////////
 	
+	// Skipped if the sprite is outside of the target's view
+	virtual void draw(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default) const
+	{
+	    syncSprite();
+	    if(Culling::test(Rect<double>(states.transform.transformRect(sprite.getGlobalBounds())), Culling::getViewRect(target.getView())))
+        {
+            target.draw(sprite, states);
+        }
+	}
+	
+	virtual void addToBatch(SpriteBatch& batch, const Vector2d& offset = Vectors::null, double rotation = 0) const
+	{
+	    syncSprite();
+	    batch.add(sprite, offset, rotation);
+	}
+	
+	virtual void capture(RenderSnapshot& snapshot) const
+	{
+	    syncSprite();
+	    snapshot.addSprite(sprite, getMotion(), getTurn());
+	}
+	
+	SpriteTransformActor(const TSprite& sprite_)
+		: transform(), sprite(sprite_)
+	{}
+	
+	virtual ~SpriteTransformActor(){}
+};
+
+class SpriteActor : public SpriteTransformActor<sf::Sprite>
+{	
+public:
+	
 	void setSize(const Vector2i& newSize)
 	{
 		sprite.setTextureRect(sf::IntRect(sprite.getTextureRect().left, sprite.getTextureRect().top, newSize.x, newSize.y));
@@ -368,86 +784,55 @@ public:
 		return Rect<int>(sprite.getTextureRect()).position;
 	}
 	
-	
-	virtual void draw(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default) const
-	{
-		target.draw(sprite, states);
-	}
-	
-	
-	
 	SpriteActor(const sf::Texture& texture, const sf::IntRect& rect)
-		: sprite(texture)
-	{
-		sprite.setTextureRect(rect);
-	}
+		: SpriteTransformActor<sf::Sprite>(sf::Sprite(texture, rect))
+	{}
 	
 	virtual ~SpriteActor(){}
 	
 };
 
-class AnimatedSpriteActor : public Actor
+class AnimatedSpriteActor : public SpriteTransformActor<AnimatedSprite>
 {
 public:
 	
-	AnimatedSprite sprite;
-	
-	// Transformable
-	virtual void setPosition (const Vector2d& 	position)
-	{
-		sprite.setPosition(position);
-		updateCollider();
-	}
-	virtual void setScale	 (const Vector2d&	scale)
-	{
-		sprite.setScale(scale);
-		updateCollider();
-	}
-	virtual void setRotation (double 			rotation)
+	Vector2i getSize() const
 	{
-		sprite.setRotation(rotation);
-		updateCollider();
+		return Rect<int>(sprite.getTextureRect()).size;
 	}
 	
-	virtual Vector2d getPosition() 	const
+	Vector2i getOffset() const
 	{
-		return sprite.getPosition();
+		return Rect<int>(sprite.getTextureRect()).position;
 	}
-	virtual Vector2d getScale() 	const
+	
+	void setPreset(const AnimatedSpritePreset& preset, bool noReset = false)
 	{
-		return sprite.getScale();
+	    sprite.setPreset(preset, noReset);
 	}
-	virtual double	 getRotation()	const
+	
+	// Applied from the next frame of the animation on
+	void setFlip(bool flipX, bool flipY = false)
 	{
-		return sprite.getRotation();
+	    sprite.flipX = flipX;
+	    sprite.flipY = flipY;
 	}
-	//////////
-	
-	Vector2i getSize() const
+	bool isFlippedX() const
 	{
-		return Rect<int>(sprite.getTextureRect()).size;
+	    return sprite.flipX;
 	}
-	
-	Vector2i getOffset() const
+	bool isFlippedY() const
 	{
-		return Rect<int>(sprite.getTextureRect()).position;
+	    return sprite.flipY;
 	}
 	
-	
-	
 	virtual void update(double deltaTime)
 	{
 		sprite.updateFrame(deltaTime);
 	}
 	
-	virtual void draw(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default) const
-	{
-		target.draw(sprite, states);
-	}
-	
-	
 	AnimatedSpriteActor(const AnimatedSpritePreset& preset)
-		: sprite(preset)
+		: SpriteTransformActor<AnimatedSprite>(AnimatedSprite(preset))
 	{
 		
 	}
@@ -1,6 +1,10 @@
 #ifndef PLATFORM_HPP_INCLUDED
 #define PLATFORM_HPP_INCLUDED
 
+#include <vector>
+#include <algorithm>
+#include "StaticBVH.hpp"
+
 class Platform : public FixedSimpleSegmentCollider
 {
     
@@ -42,24 +46,97 @@ public:
                 
 	}
 	
+	// Segments lying on the same line cancel out where they overlap, the same way
+	// pairwise merge() does, so walls shared by neighbouring rooms disappear.
+	// Segments are bucketed by orientation and offset and sorted, after which every
+	// bucket is resolved in a single pass: for sorted endpoints p0 <= p1 <= p2 ...
+	// the parts covered an odd number of times are exactly [p0,p1], [p2,p3], ...
 	static void mergeAll(std::vector<Platform>& platforms)
 	{
-	    for(auto i=0u; i<platforms.size(); i++)
+	    std::vector<Platform> input;
+	    input.reserve(platforms.size());
+	    for(const Platform& platform : platforms)
         {
-            for(auto j=i+1u; j<platforms.size(); j++)
+            if(platform.collider.length >= 0.001)
             {
-                merge(platforms[i], platforms[j]);
+                input.push_back(platform);
             }
         }
         
-        platforms.erase(std::remove_if(platforms.begin(), platforms.end(), [](const Platform& platform){return platform.collider.length <= 0.001;}), platforms.end());
+        std::sort(input.begin(), input.end(), [](const Platform& p1, const Platform& p2)
+        {
+            if(p1.collider.isVertical != p2.collider.isVertical)
+                return p1.collider.isVertical < p2.collider.isVertical;
+            if(p1.collider.getOffset() != p2.collider.getOffset())
+                return p1.collider.getOffset() < p2.collider.getOffset();
+            return p1.collider.getStartValue() < p2.collider.getStartValue();
+        });
+        
+        platforms.clear();
+        std::vector<double> endpoints;
+        for(auto first = 0u; first < input.size(); )
+        {
+            const SimpleSegment<double>& line = input[first].collider;
+            auto last = first;
+            endpoints.clear();
+            while(last < input.size() &&
+                  input[last].collider.isVertical == line.isVertical &&
+                  input[last].collider.getOffset() - line.getOffset() <= 0.001)
+            {
+                endpoints.push_back(input[last].collider.getStartValue());
+                endpoints.push_back(input[last].collider.getEndValue());
+                last++;
+            }
+            
+            std::sort(endpoints.begin(), endpoints.end());
+            for(auto i = 0u; i + 1 < endpoints.size(); i += 2)
+            {
+                if(endpoints[i+1] - endpoints[i] > 0.001)
+                {
+                    Vector2d position = line.isVertical ? Vector2d(line.getOffset(), endpoints[i]) : Vector2d(endpoints[i], line.getOffset());
+                    platforms.emplace_back(position, endpoints[i+1] - endpoints[i], line.isVertical);
+                }
+            }
+            first = last;
+        }
+	}
+	
+	
+	static void buildBVH(const std::vector<Platform>& platforms, StaticBVH& bvh)
+	{
+	    std::vector<Rect<double> > boxes;
+	    boxes.reserve(platforms.size());
+	    for(const Platform& platform : platforms)
+        {
+            boxes.push_back(platform.collider.getBoundingRect());
+        }
+        bvh.build(boxes);
 	}
 	
+	// First platform crossed by the segment
+	static bool raycast(const std::vector<Platform>& platforms, const StaticBVH& bvh, const Line<double>& segment, unsigned int& hitIndex, double& hitFraction)
+	{
+	    return bvh.raycast(segment, [&](unsigned int index, double& fraction)
+        {
+            return Collision::raycast(segment, platforms[index].collider, fraction);
+        }, hitIndex, hitFraction);
+	}
+	
+	// Every platform crossed by the segment, handler(index, fraction) returns true to stop
+	template<class THandler>
+	static void raycastAll(const std::vector<Platform>& platforms, const StaticBVH& bvh, const Line<double>& segment, THandler handler)
+	{
+	    bvh.raycastAll(segment, [&](unsigned int index)
+        {
+            double fraction;
+            return Collision::raycast(segment, platforms[index].collider, fraction) && handler(index, fraction);
+        });
+	}
 	
 	Platform(const Vector2d& position, double length, bool isVertical)
 		: FixedSimpleSegmentCollider(SimpleSegment<double>(position, length, isVertical))
 	{
-		
+		layer = CollisionLayers::Platform;
 	}
 	
 	virtual ~Platform(){}
@@ -81,5 +158,6 @@ public:
 };
 
 std::vector<Platform> platforms;
+StaticBVH             platformBVH;
 
 #endif // PLATFORM_HPP_INCLUDED
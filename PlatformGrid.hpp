@@ -0,0 +1,184 @@
+#ifndef PLATFORMGRID_HPP_INCLUDED
+#define PLATFORMGRID_HPP_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include "Shapes.hpp"
+#include "PLatform.hpp"
+
+// Uniform grid over the merged platforms. Every cell keeps the indices of the
+// platforms whose bounds touch it, stored back to back in one array
+// (cellStart[i] .. cellStart[i+1] are the entries of cell i).
+class PlatformGrid
+{
+    double      cellSize;
+    Vector2d    origin;
+    int         columns;
+    int         rows;
+
+    std::vector<unsigned int> cellStart;
+    std::vector<unsigned int> cellItems;
+    std::vector<Rect<double> > bounds;
+    std::vector<unsigned int> layers;
+
+    int getColumn(double x) const
+    {
+        return std::min(std::max(static_cast<int>(std::floor((x - origin.x) / cellSize)), 0), columns - 1);
+    }
+    int getRow(double y) const
+    {
+        return std::min(std::max(static_cast<int>(std::floor((y - origin.y) / cellSize)), 0), rows - 1);
+    }
+
+public:
+
+    void clear()
+    {
+        columns = 0;
+        rows    = 0;
+        cellStart.clear();
+        cellItems.clear();
+        bounds.clear();
+        layers.clear();
+    }
+
+    bool isBuilt() const
+    {
+        return columns > 0 && rows > 0;
+    }
+
+    double getCellSize() const
+    {
+        return cellSize;
+    }
+
+    // Has to be called again every time the platforms vector changes (e.g. after Platform::mergeAll)
+    void build(const std::vector<Platform>& platforms)
+    {
+        clear();
+        if(platforms.empty())
+        {
+            return;
+        }
+
+        bounds.reserve(platforms.size());
+        layers.reserve(platforms.size());
+        Vector2d mn = platforms[0].collider.position;
+        Vector2d mx = mn;
+        for(const Platform& platform : platforms)
+        {
+            bounds.push_back(platform.collider.getBoundingRect());
+            layers.push_back(platform.getLayer());
+            const Rect<double>& rect = bounds.back();
+            mn.x = std::min(mn.x, rect.position.x);
+            mn.y = std::min(mn.y, rect.position.y);
+            mx.x = std::max(mx.x, rect.position.x + rect.size.x);
+            mx.y = std::max(mx.y, rect.position.y + rect.size.y);
+        }
+
+        origin  = mn;
+        columns = static_cast<int>(std::floor((mx.x - mn.x) / cellSize)) + 1;
+        rows    = static_cast<int>(std::floor((mx.y - mn.y) / cellSize)) + 1;
+
+        // Counting pass, then prefix sum, then the filling pass
+        cellStart.assign(columns * rows + 1, 0);
+        for(const Rect<double>& rect : bounds)
+        {
+            for(int row = getRow(rect.position.y); row <= getRow(rect.position.y + rect.size.y); row++)
+            {
+                for(int column = getColumn(rect.position.x); column <= getColumn(rect.position.x + rect.size.x); column++)
+                {
+                    cellStart[row * columns + column + 1]++;
+                }
+            }
+        }
+        for(unsigned int i=1; i<cellStart.size(); i++)
+        {
+            cellStart[i] += cellStart[i-1];
+        }
+
+        cellItems.resize(cellStart.back());
+        std::vector<unsigned int> fill(cellStart.begin(), cellStart.end() - 1);
+        for(unsigned int i=0; i<bounds.size(); i++)
+        {
+            const Rect<double>& rect = bounds[i];
+            for(int row = getRow(rect.position.y); row <= getRow(rect.position.y + rect.size.y); row++)
+            {
+                for(int column = getColumn(rect.position.x); column <= getColumn(rect.position.x + rect.size.x); column++)
+                {
+                    cellItems[fill[row * columns + column]++] = i;
+                }
+            }
+        }
+    }
+
+    // Calls handler(index) once for every platform sharing a cell with the area
+    // and lying on a layer from the mask.
+    // A platform spanning several cells is reported only from the first cell
+    // shared with the area, so no per-query bookkeeping is needed.
+    template<class THandler>
+    void iterate(const Rect<double>& area, THandler handler, unsigned int mask = CollisionLayers::All) const
+    {
+        if(!isBuilt())
+        {
+            return;
+        }
+
+        int minColumn = getColumn(area.position.x);
+        int maxColumn = getColumn(area.position.x + area.size.x);
+        int minRow    = getRow(area.position.y);
+        int maxRow    = getRow(area.position.y + area.size.y);
+
+        for(int row = minRow; row <= maxRow; row++)
+        {
+            for(int column = minColumn; column <= maxColumn; column++)
+            {
+                unsigned int cell = row * columns + column;
+                for(unsigned int i = cellStart[cell]; i < cellStart[cell+1]; i++)
+                {
+                    unsigned int index = cellItems[i];
+                    if(!(layers[index] & mask))
+                    {
+                        continue;
+                    }
+                    const Rect<double>& rect = bounds[index];
+                    if(std::max(getColumn(rect.position.x), minColumn) != column ||
+                       std::max(getRow(rect.position.y), minRow) != row)
+                    {
+                        continue;
+                    }
+                    handler(index);
+                }
+            }
+        }
+    }
+
+    // Distance between the box and the closest platform bounds on a layer from
+    // the mask, or maxDistance if nothing is closer. Never more than the real
+    // distance to the platforms, so moving by less can't pass through one.
+    double getClearance(const Rect<double>& box, double maxDistance, unsigned int mask = CollisionLayers::All) const
+    {
+        if(!isBuilt())
+        {
+            return 0;
+        }
+        Rect<double> area(box.position - Vector2d(maxDistance, maxDistance), box.size + Vector2d(maxDistance, maxDistance) * 2.0);
+        double best = maxDistance * maxDistance;
+        iterate(area, [&](unsigned int index)
+        {
+            const Rect<double>& rect = bounds[index];
+            double dx = std::max(std::max(rect.position.x - box.position.x - box.size.x, box.position.x - rect.position.x - rect.size.x), 0.0);
+            double dy = std::max(std::max(rect.position.y - box.position.y - box.size.y, box.position.y - rect.position.y - rect.size.y), 0.0);
+            best = std::min(best, dx*dx + dy*dy);
+        }, mask);
+        return std::sqrt(best);
+    }
+
+    PlatformGrid(double cellSize_ = 64)
+        : cellSize(cellSize_), origin(Vectors::null), columns(0), rows(0)
+    {}
+};
+
+PlatformGrid platformGrid;
+
+#endif // PLATFORMGRID_HPP_INCLUDED
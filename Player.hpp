@@ -41,18 +41,18 @@ public:
 		{
 			if(isWalking)
 			{
-				player.sprite.setPreset(AnimatedSpritePresets::PlayerWalk);
+				player.setPreset(AnimatedSpritePresets::PlayerWalk);
 			}
 			else if(isInAir)
 			{
-				player.sprite.setPreset(AnimatedSpritePresets::PlayerFall);
+				player.setPreset(AnimatedSpritePresets::PlayerFall);
 			}
 			else
 			{
-				player.sprite.setPreset(AnimatedSpritePresets::PlayerIdle);
+				player.setPreset(AnimatedSpritePresets::PlayerIdle);
 			}
 			
-			player.sprite.flipX = !isTurnedRight;
+			player.setFlip(!isTurnedRight);
 		}
 				
 	}	stateManager;
@@ -96,7 +96,7 @@ public:
 		
 		updateSubstepKinematics(deltaTime, step, 2, [this](double deltaTime)
         {
-            Vector2d shift = moveOutOfWalls(platforms);
+            Vector2d shift = moveOutOfWalls(platforms, platformGrid);
             stateManager.isInAir = shift.y >= 0;
         });
         
@@ -121,6 +121,7 @@ public:
 		: AnimatedSpriteActor(AnimatedSpritePresets::PlayerIdle)
 	{
 		setPosition(position);
+		setCollisionLayers(CollisionLayers::Player);
 		/*
 		setCollider(Rect<double>(
                            (PlayerSprite::width - colliderWidth) / 2,
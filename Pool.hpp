@@ -0,0 +1,160 @@
+#ifndef POOL_HPP_INCLUDED
+#define POOL_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <type_traits>
+
+// Heap allocations counted for the stats. Pools and arenas count the chunks
+// they take from the heap; with PRINT_STATS main.cpp replaces the global new
+// to count every other allocation too.
+class AllocationStats
+{
+    static std::atomic<unsigned int> heapAllocations;
+
+public:
+
+    static void count()
+    {
+        heapAllocations++;
+    }
+
+    // Allocations since the last call
+    static unsigned int takeHeapAllocations()
+    {
+        return heapAllocations.exchange(0);
+    }
+};
+
+std::atomic<unsigned int> AllocationStats::heapAllocations(0);
+
+// Fixed size blocks for objects of one type, carved out of chunks taken from
+// the heap; freed blocks go on a free list and are reused first. Once the
+// pool has grown to the peak number of objects, it no longer allocates.
+template<class T>
+class Pool
+{
+    union Block
+    {
+        Block* next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    std::vector<Block*> chunks;
+    Block*              freeList;
+    unsigned int        chunkSize;
+    unsigned int        used;
+    unsigned int        capacity;
+    mutable std::mutex  mutex;
+
+    void grow()
+    {
+        Block* chunk = static_cast<Block*>(std::malloc(chunkSize * sizeof(Block)));
+        if(!chunk)
+        {
+            throw std::bad_alloc();
+        }
+        AllocationStats::count();
+        chunks.push_back(chunk);
+        for(unsigned int i=0; i<chunkSize; i++)
+        {
+            chunk[i].next = freeList;
+            freeList = &chunk[i];
+        }
+        capacity  += chunkSize;
+        chunkSize *= 2;
+    }
+
+public:
+
+    void* allocate()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!freeList)
+        {
+            grow();
+        }
+        Block* block = freeList;
+        freeList = block->next;
+        used++;
+        return block;
+    }
+
+    void deallocate(void* memory)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Block* block = static_cast<Block*>(memory);
+        block->next = freeList;
+        freeList = block;
+        used--;
+    }
+
+    // Locked as well, so the stats can be read while jobs allocate
+    unsigned int getUsedCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return used;
+    }
+
+    unsigned int getCapacity() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return capacity;
+    }
+
+    // Never destroyed, so objects can still be freed during static destruction
+    static Pool<T>& get()
+    {
+        static Pool<T>* pool = new Pool<T>;
+        return *pool;
+    }
+
+    Pool(unsigned int firstChunkSize = 16)
+        : freeList(nullptr), chunkSize(firstChunkSize ? firstChunkSize : 1), used(0), capacity(0)
+    {}
+
+    ~Pool()
+    {
+        for(Block* chunk : chunks)
+        {
+            std::free(chunk);
+        }
+    }
+};
+
+// Base giving T a class operator new taking its objects from Pool<T>.
+// Classes deriving from T that aren't pooled themselves fall back to the heap.
+template<class T>
+class Pooled
+{
+public:
+
+    static void* operator new(std::size_t size)
+    {
+        if(size != sizeof(T))
+        {
+            return ::operator new(size);
+        }
+        return Pool<T>::get().allocate();
+    }
+
+    static void operator delete(void* memory, std::size_t size)
+    {
+        if(!memory)
+        {
+            return;
+        }
+        if(size != sizeof(T))
+        {
+            ::operator delete(memory);
+            return;
+        }
+        Pool<T>::get().deallocate(memory);
+    }
+};
+
+#endif // POOL_HPP_INCLUDED
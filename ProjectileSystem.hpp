@@ -0,0 +1,368 @@
+#ifndef PROJECTILESYSTEM_HPP_INCLUDED
+#define PROJECTILESYSTEM_HPP_INCLUDED
+
+#include <vector>
+#include <limits>
+#include "Object.hpp"
+#include "Archetype.hpp"
+#include "Components.hpp"
+#include "SmallVector.hpp"
+
+// Projectiles kept as rows of an archetype instead of one actor each.
+// Velocities are integrated by the systems walking the columns; collisions
+// are then resolved per projectile in chunks on the job system, against the
+// platform grid and the rects of the targets.
+// All projectiles of a system share their collision layers and sprite.
+// A projectile dies when its lifetime runs out, when it has been resting for
+// long enough or when it leaves the bounds; the last one is moved into its
+// row, so the columns stay dense and their memory is reused by later spawns.
+class ProjectileSystem
+{
+public:
+    static constexpr unsigned int maxSweeps = 4;
+
+    struct Radius
+    {
+        double value;
+    };
+
+    // Seconds left
+    struct Lifetime
+    {
+        double value;
+    };
+
+    // Seconds spent slower than the rest speed
+    struct RestingTime
+    {
+        double value;
+    };
+
+    typedef Archetype<Components::Position, Components::PreviousPosition, Components::Velocity, Components::Mass,
+                      Radius, Lifetime, RestingTime> Projectiles;
+    typedef Projectiles::Entity Entity;
+
+    // Targets for systems that only hit platforms
+    struct NoTargets
+    {
+        typedef int Id;
+
+        template<class THandler>
+        void query(const Rect<double>& area, unsigned int mask, THandler handler) const
+        {}
+    };
+
+private:
+    Projectiles     projectiles;
+
+    unsigned int    layer;
+    unsigned int    mask;
+    sf::Sprite      sprite;
+
+    double          defaultLifetime;
+    double          restSpeed;
+    double          restDuration;
+    bool            hasBounds;
+    Rect<double>    bounds;
+
+    bool canCollideWith(const Collider& c) const
+    {
+        return (mask & c.getLayer()) && (c.getMask() & layer);
+    }
+
+    void countDownLifetimes(double deltaTime)
+    {
+        std::vector<Lifetime>& lifetimes = projectiles.getColumn<Lifetime>();
+        for(unsigned int i=0; i<lifetimes.size(); i++)
+        {
+            lifetimes[i].value -= deltaTime;
+        }
+    }
+
+    void updateRestingTimes(double deltaTime)
+    {
+        const std::vector<Components::Velocity>& velocities   = projectiles.getColumn<Components::Velocity>();
+        std::vector<RestingTime>&                restingTimes = projectiles.getColumn<RestingTime>();
+        const double restSpeedSquared = restSpeed * restSpeed;
+        for(unsigned int i=0; i<velocities.size(); i++)
+        {
+            restingTimes[i].value = velocities[i].value.magnatudeSquared() < restSpeedSquared ? restingTimes[i].value + deltaTime : 0;
+        }
+    }
+
+    bool isDead(unsigned int i) const
+    {
+        if(projectiles.getColumn<Lifetime>()[i].value <= 0 || projectiles.getColumn<RestingTime>()[i].value >= restDuration)
+        {
+            return true;
+        }
+        const Vector2d& position = projectiles.getColumn<Components::Position>()[i].value;
+        return hasBounds && (position.x < bounds.position.x || position.x > bounds.position.x + bounds.size.x ||
+                             position.y < bounds.position.y || position.y > bounds.position.y + bounds.size.y);
+    }
+
+    // Returns the number of projectiles removed
+    unsigned int reap()
+    {
+        unsigned int removed = 0;
+        for(unsigned int i = size(); i-- > 0;)
+        {
+            if(isDead(i))
+            {
+                projectiles.destroy(projectiles.getEntity(i));
+                removed++;
+            }
+        }
+        return removed;
+    }
+
+    // Continuous collision: the projectile moves straight to its first contact
+    // with a platform, loses the velocity going into it and continues with the
+    // rest of the step. Targets swept on the way are hit without stopping it.
+    // Hits are collected during the target queries and reported after them,
+    // so onHit never runs while the targets are being traversed.
+    template<class TTargets, class THitHandler>
+    void resolve(unsigned int i, double deltaTime, const TTargets& targets, THitHandler& onHit)
+    {
+        SmallVector<typename TTargets::Id, 4> hits;
+
+        Vector2d& position = projectiles.getColumn<Components::Position>()[i].value;
+        Vector2d& velocity = projectiles.getColumn<Components::Velocity>()[i].value;
+        const double r     = projectiles.getColumn<Radius>()[i].value;
+
+        double timeLeft = deltaTime;
+        for(unsigned int sweep = 0; sweep < maxSweeps && timeLeft > 0; sweep++)
+        {
+            const Circle<double> circle(position, r);
+            Vector2d displacement = velocity * timeLeft;
+            if(displacement.magnatudeSquared() == 0)
+            {
+                break;
+            }
+
+            Rect<double> bounds = circle.getBoundingRect();
+            Rect<double> swept(Vector2d(std::min(bounds.position.x, bounds.position.x + displacement.x), std::min(bounds.position.y, bounds.position.y + displacement.y)),
+                               bounds.size + Vector2d(std::abs(displacement.x), std::abs(displacement.y)));
+
+            double   hitFraction = 1;
+            Vector2d hitNormal;
+            bool     hit = false;
+            auto testPlatform = [&](const Platform& platform)
+            {
+                double   fraction;
+                Vector2d normal;
+                if(canCollideWith(platform) && Collision::sweep(circle, displacement, platform.collider, fraction, normal) && fraction < hitFraction)
+                {
+                    hit         = true;
+                    hitFraction = fraction;
+                    hitNormal   = normal;
+                }
+            };
+            if(platformGrid.isBuilt())
+            {
+                platformGrid.iterate(swept, [&](unsigned int index){testPlatform(platforms[index]);}, mask);
+            }
+            else
+            {
+                for(const Platform& platform : platforms)
+                {
+                    testPlatform(platform);
+                }
+            }
+
+            targets.query(swept, mask, [&](const Rect<double>& rect, const typename TTargets::Id& id)
+            {
+                double   fraction;
+                Vector2d normal;
+                if(Collision::sweep(circle, displacement, rect, fraction, normal) && fraction <= hitFraction)
+                {
+                    hits.push_back(id);
+                }
+            });
+
+            position += displacement * hitFraction;
+            if(!hit)
+            {
+                break;
+            }
+            double into = velocity.dot(hitNormal);
+            if(into < 0)
+            {
+                velocity -= hitNormal * into;
+            }
+            timeLeft *= 1 - hitFraction;
+        }
+
+        // Contacts the projectile starts the step in (resting on a floor) are not swept
+        const Rect<double> bounds = Circle<double>(position, r).getBoundingRect();
+        targets.query(bounds, mask, [&](const Rect<double>& rect, const typename TTargets::Id& id)
+        {
+            if(Collision::test(Circle<double>(position, r), rect))
+            {
+                hits.push_back(id);
+            }
+        });
+        for(const typename TTargets::Id& id : hits)
+        {
+            onHit(id);
+        }
+
+        auto moveOutOfPlatform = [&](const Platform& platform)
+        {
+            if(!canCollideWith(platform))
+            {
+                return;
+            }
+            Collision::Result result = Collision::test(Circle<double>(position, r), platform.collider);
+            if(result)
+            {
+                if(platform.collider.isVertical)
+                {
+                    velocity.x = 0;
+                }
+                else
+                {
+                    velocity.y = 0;
+                }
+                position += result.getPenetrationVector();
+            }
+        };
+        if(platformGrid.isBuilt())
+        {
+            platformGrid.iterate(bounds, [&](unsigned int index){moveOutOfPlatform(platforms[index]);}, mask);
+        }
+        else
+        {
+            for(const Platform& platform : platforms)
+            {
+                moveOutOfPlatform(platform);
+            }
+        }
+    }
+
+public:
+
+    unsigned int size() const
+    {
+        return projectiles.size();
+    }
+
+    Vector2d getPosition(unsigned int i) const
+    {
+        return projectiles.getColumn<Components::Position>()[i].value;
+    }
+
+    Vector2d getVelocity(unsigned int i) const
+    {
+        return projectiles.getColumn<Components::Velocity>()[i].value;
+    }
+
+    // Seconds left, counting down from the lifetime given at spawn
+    double getLifetime(unsigned int i) const
+    {
+        return projectiles.getColumn<Lifetime>()[i].value;
+    }
+
+    const Projectiles& getProjectiles() const
+    {
+        return projectiles;
+    }
+
+    // Lifetime in seconds, the default lifetime if negative
+    Entity spawn(const Vector2d& position, const Vector2d& velocity, double radius, double mass, double lifetime = -1)
+    {
+        return projectiles.create(Components::Position{position}, Components::PreviousPosition{position}, Components::Velocity{velocity}, Components::Mass{mass},
+                                  Radius{radius}, Lifetime{lifetime < 0 ? defaultLifetime : lifetime}, RestingTime{0});
+    }
+
+    void clear()
+    {
+        projectiles.clear();
+    }
+
+    void setDefaultLifetime(double lifetime)
+    {
+        defaultLifetime = lifetime;
+    }
+
+    // A projectile slower than speed for duration seconds is at rest and dies
+    void setRestDetection(double speed, double duration)
+    {
+        restSpeed    = speed;
+        restDuration = duration;
+    }
+
+    // Projectiles leaving the area die
+    void setBounds(const Rect<double>& bounds_)
+    {
+        hasBounds = true;
+        bounds    = bounds_;
+    }
+    void removeBounds()
+    {
+        hasBounds = false;
+    }
+
+    // TTargets::query(area, mask, handler) calls handler(rect, id) for the
+    // targets near the area whose layers match the mask; TTargets::Id names them.
+    // onHit(id) is called from the jobs for every target hit, so it has to go
+    // through CommandBuffer::defer for anything it changes.
+    // Returns the number of projectiles that died.
+    template<class TTargets, class THitHandler>
+    unsigned int update(double deltaTime, const TTargets& targets, THitHandler onHit, JobSystem& jobs = jobSystem, unsigned int chunkSize = 256)
+    {
+        Systems::savePreviousPositions(projectiles);
+        Systems::applyGravity(projectiles, globalGravity, deltaTime);
+        countDownLifetimes(deltaTime);
+        jobs.parallelFor(size(), chunkSize, [&](unsigned int begin, unsigned int end)
+        {
+            for(unsigned int i = begin; i < end; i++)
+            {
+                resolve(i, deltaTime, targets, onHit);
+            }
+        });
+        jobs.flushCommandBuffers();
+        Systems::applyDrag(projectiles, globalDrag, deltaTime);
+        updateRestingTimes(deltaTime);
+        return reap();
+    }
+
+    void capture(RenderSnapshot& snapshot) const
+    {
+        sf::Sprite positioned(sprite);
+        projectiles.each<Components::Position, Components::PreviousPosition>([&](const Components::Position& position, const Components::PreviousPosition& previous)
+        {
+            positioned.setPosition(position.value.x, position.value.y);
+            snapshot.addSprite(positioned, position.value - previous.value);
+        });
+    }
+
+    // Adds every projectile to the batch, to be drawn by its next flush
+    void draw(SpriteBatch& batch, double interpolation = 1) const
+    {
+        sf::Sprite positioned(sprite);
+        positioned.setPosition(0, 0);
+        projectiles.each<Components::Position, Components::PreviousPosition>([&](const Components::Position& position, const Components::PreviousPosition& previous)
+        {
+            batch.add(positioned, RenderSnapshot::interpolate(position.value, position.value - previous.value, interpolation));
+        });
+    }
+
+    void draw(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default, double interpolation = 1) const
+    {
+        SpriteBatch batch;
+        batch.setCullRect(Culling::getViewRect(target.getView()));
+        draw(batch, interpolation);
+        batch.flush(target, states);
+    }
+
+    // The sprite's position is ignored, everything else is used for every projectile
+    ProjectileSystem(const sf::Sprite& sprite_, unsigned int layer_, unsigned int mask_)
+        : layer(layer_), mask(mask_), sprite(sprite_),
+          defaultLifetime(std::numeric_limits<double>::infinity()), restSpeed(0), restDuration(std::numeric_limits<double>::infinity()), hasBounds(false), bounds(0, 0, 0, 0)
+    {}
+};
+
+constexpr unsigned int ProjectileSystem::maxSweeps;
+
+#endif // PROJECTILESYSTEM_HPP_INCLUDED
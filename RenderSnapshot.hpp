@@ -0,0 +1,162 @@
+#ifndef RENDERSNAPSHOT_HPP_INCLUDED
+#define RENDERSNAPSHOT_HPP_INCLUDED
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <cmath>
+#include "Vectors.hpp"
+#include "StaticMesh.hpp"
+#include "SpriteBatch.hpp"
+
+// Everything needed to draw one simulated state, copied out of the actors so
+// it can be drawn on another thread while the simulation moves on.
+// Every entry also keeps how far it moved and turned during the last step,
+// so a frame drawn between two steps can put it in between.
+struct RenderSnapshot
+{
+    struct SpriteState
+    {
+        sf::Sprite      sprite;
+        sf::Vector2f    motion;
+        float           turn;
+    };
+
+    struct LightState
+    {
+        Vector2d    position;
+        Vector2d    motion;
+        double      radius;
+    };
+
+    std::vector<SpriteState>    sprites;
+    std::vector<LightState>     lights;
+
+    // Shared with the level, which bakes a new mesh instead of changing this one
+    std::shared_ptr<const StaticMesh> staticMesh;
+
+    double                                  step = 0;
+    std::chrono::steady_clock::time_point   time;
+
+    void clear()
+    {
+        sprites.clear();
+        lights.clear();
+        staticMesh.reset();
+    }
+
+    // turn is in degrees, around the sprite's origin
+    void addSprite(const sf::Sprite& sprite, const Vector2d& motion, double turn = 0)
+    {
+        sprites.push_back(SpriteState{sprite, motion, float(turn)});
+    }
+
+    void addLight(const Vector2d& position, const Vector2d& motion, double radius)
+    {
+        lights.push_back(LightState{position, motion, radius});
+    }
+
+    // 0 right after publishing, 1 once a whole step has passed since
+    double getInterpolation(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const
+    {
+        if(step <= 0)
+        {
+            return 1;
+        }
+        double elapsed = std::chrono::duration<double>(now - time).count();
+        return std::min(std::max(elapsed / step, 0.0), 1.0);
+    }
+
+    static Vector2d interpolate(const Vector2d& position, const Vector2d& motion, double interpolation)
+    {
+        return position - motion * (1 - interpolation);
+    }
+
+    // Rotation from previous to current in degrees, the short way round
+    static double getTurn(double previous, double current)
+    {
+        double turn = std::fmod(current - previous, 360.0);
+        if(turn >= 180)
+        {
+            turn -= 360;
+        }
+        else if(turn < -180)
+        {
+            turn += 360;
+        }
+        return turn;
+    }
+
+    // Only the parts of the mesh intersecting the view
+    void drawStaticMesh(sf::RenderTarget& target, const Rect<double>& view, const sf::RenderStates& states = sf::RenderStates::Default) const
+    {
+        if(staticMesh)
+        {
+            staticMesh->draw(target, view, states);
+        }
+    }
+
+    // Goes through the batch, so every texture is one draw call; the batch's
+    // cull rect decides which sprites are drawn
+    void drawSprites(sf::RenderTarget& target, double interpolation, SpriteBatch& batch, const sf::RenderStates& states = sf::RenderStates::Default) const
+    {
+        for(const SpriteState& state : sprites)
+        {
+            const sf::Vector2f offset = state.motion * float(interpolation - 1);
+            batch.add(state.sprite, Vector2d(offset.x, offset.y), state.turn * (interpolation - 1));
+        }
+        batch.flush(target, states);
+    }
+};
+
+// Hands snapshots from the simulation to the renderer without either one
+// waiting for the other to finish with its buffer: the simulation fills its
+// own, the renderer draws its own, and the latest finished one waits in the
+// middle slot.
+class RenderSnapshotBuffer
+{
+    RenderSnapshot  buffers[3];
+    RenderSnapshot* writing;
+    RenderSnapshot* ready;
+    RenderSnapshot* reading;
+    bool            isFresh;
+    std::mutex      mutex;
+
+public:
+
+    // Simulation side: an emptied snapshot to fill, then publish() it
+    RenderSnapshot& beginWrite()
+    {
+        writing->clear();
+        return *writing;
+    }
+
+    void publish()
+    {
+        writing->time = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(writing, ready);
+        isFresh = true;
+    }
+
+    // Render side: the latest published snapshot, valid until the next call
+    const RenderSnapshot& acquire()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(isFresh)
+        {
+            std::swap(reading, ready);
+            isFresh = false;
+        }
+        return *reading;
+    }
+
+    RenderSnapshotBuffer()
+        : writing(&buffers[0]), ready(&buffers[1]), reading(&buffers[2]), isFresh(false)
+    {}
+};
+
+#endif // RENDERSNAPSHOT_HPP_INCLUDED
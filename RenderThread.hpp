@@ -0,0 +1,136 @@
+#ifndef RENDERTHREAD_HPP_INCLUDED
+#define RENDERTHREAD_HPP_INCLUDED
+
+#include <SFML/Graphics.hpp>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include "RenderSnapshot.hpp"
+#include "LightEmitter.hpp"
+#include "TaskGraph.hpp"
+#include "Culling.hpp"
+
+// Draws the latest published snapshot on its own thread, as often as the
+// window allows, independently of the simulation rate. Never touches the
+// actors, only the snapshots and the static level geometry. Sprites, the
+// static mesh and lights outside of the window's view are skipped.
+// The frame's jobs run on a JobSystem of its own, so the simulation never
+// builds frame geometry and the frame never runs simulation chunks.
+class RenderThread
+{
+    sf::RenderWindow&       window;
+    RenderSnapshotBuffer&   snapshots;
+    JobSystem               jobs;
+
+    std::thread             thread;
+    std::atomic<bool>       running;
+
+    // Frame stages; shadow geometry is built on the job system while the sprites are drawn
+    TaskGraph               frame;
+    const RenderSnapshot*   snapshot;
+    double                  interpolation;
+    Rect<double>            viewRect;
+    std::vector<RenderSnapshot::LightState> visibleLights;
+    std::vector<sf::VertexArray> shadows;
+    SpriteBatch             spriteBatch;
+
+    void loop()
+    {
+        window.setActive(true);
+        while(running)
+        {
+            snapshot      = &snapshots.acquire();
+            interpolation = snapshot->getInterpolation();
+            viewRect      = Culling::getViewRect(window.getView());
+            frame.run(jobs);
+        }
+        window.setActive(false);
+        LightEmitter::setTexturesActive(false);
+    }
+
+public:
+
+    const TaskGraph& getFrameGraph() const
+    {
+        return frame;
+    }
+
+    // The window and the light map textures belong to the render thread until stop()
+    void start()
+    {
+        if(running)
+        {
+            return;
+        }
+        window.setActive(false);
+        LightEmitter::setTexturesActive(false);
+        running = true;
+        thread  = std::thread(&RenderThread::loop, this);
+    }
+
+    void stop()
+    {
+        if(!running)
+        {
+            return;
+        }
+        running = false;
+        thread.join();
+        window.setActive(true);
+    }
+
+    // jobThreads counts the render thread, which takes the job system's only external slot
+    RenderThread(sf::RenderWindow& window_, RenderSnapshotBuffer& snapshots_, unsigned int jobThreads = 2)
+        : window(window_), snapshots(snapshots_), jobs(jobThreads, 1), running(false), snapshot(nullptr), interpolation(1), viewRect(0, 0, 0, 0)
+    {
+        unsigned int shadowsTask = frame.addTask("shadows", [this]
+        {
+            // Lights not reaching into the view add nothing to the light map
+            visibleLights.clear();
+            for(const RenderSnapshot::LightState& light : snapshot->lights)
+            {
+                Vector2d position = RenderSnapshot::interpolate(light.position, light.motion, interpolation);
+                if(Culling::test(Rect<double>(position - Vector2d(light.radius, light.radius), Vector2d(light.radius, light.radius) * 2), viewRect))
+                {
+                    visibleLights.push_back(light);
+                }
+            }
+            shadows.resize(visibleLights.size());
+            for(unsigned int i=0; i<visibleLights.size(); i++)
+            {
+                const RenderSnapshot::LightState& light = visibleLights[i];
+                PointLightEmitter::mapPlatformsShadows(RenderSnapshot::interpolate(light.position, light.motion, interpolation), light.radius, shadows[i]);
+            }
+        });
+
+        unsigned int spritesTask = frame.addTask("sprites", [this]
+        {
+            window.clear(sf::Color::Black);
+            spriteBatch.setCullRect(viewRect);
+            snapshot->drawStaticMesh(window, viewRect);
+            snapshot->drawSprites(window, interpolation, spriteBatch);
+        }, true);
+
+        unsigned int lightmapTask = frame.addTask("lightmap", [this]
+        {
+            PointLightEmitter::renderLightMap(visibleLights, shadows, interpolation);
+        }, true);
+
+        unsigned int presentTask = frame.addTask("present", [this]
+        {
+            LightEmitter::applyLightMap(window);
+            window.display();
+        }, true);
+
+        frame.addDependency(shadowsTask,  lightmapTask);
+        frame.addDependency(spritesTask,  presentTask);
+        frame.addDependency(lightmapTask, presentTask);
+    }
+
+    ~RenderThread()
+    {
+        stop();
+    }
+};
+
+#endif // RENDERTHREAD_HPP_INCLUDED
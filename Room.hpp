@@ -5,6 +5,10 @@
 #include "PLatform.hpp"
 #include <vector>
 #include "Object.hpp"
+#include "Archetype.hpp"
+#include "Components.hpp"
+#include "StaticMesh.hpp"
+#include <memory>
 
 struct WallType
 {
@@ -24,63 +28,162 @@ namespace WallTypes
 }
 
 
-class Room : public SpriteActor, public ActorCollection<Room>
+// Rooms are rows of an archetype: the box a room takes and the sprite tiling
+// its wall texture over it. Rooms never move, so they are drawn from a mesh
+// baked from all of their sprites.
+class Room
 {
-	bool 		collidableBounds;
-		
 public:
 	
+	typedef Archetype<Components::Bounds, Components::Sprite> Rooms;
+	typedef Rooms::Entity Entity;
+	
 	static bool autoOffsetWallTexture;
 	
-	Rect<double> getRect() const
+	// Dropped whenever the room list changes and rebuilt by the next query.
+	// Changes happen at the sync points, and Cannonball::updateAll queries the
+	// bounds on the main thread every step, so jobs find it built.
+	static StaticBVH bvh;
+	
+private:
+	
+	static Rooms rooms;
+	
+	// Baked on demand like the BVH; snapshots keep the old one alive while they draw it
+	static std::shared_ptr<const StaticMesh> mesh;
+	
+	static void invalidate()
 	{
-		return Rect<double>(getPosition(), getSize());
+	    bvh.clear();
+	    mesh.reset();
 	}
 	
-	static bool isPointInside(const Vector2d& point)
+public:
+	
+	static const Rooms& getRooms()
 	{
-	    bool inside = false;
-	    iterate([&point, &inside](const Room& room)
-        {
-            inside = CollisionFast::test(point, room.getRect());
-            return inside;
-        });
-        return inside;
+	    return rooms;
+	}
+	
+	static unsigned int getCount()
+	{
+	    return rooms.size();
 	}
 	
-	Room(const Rect<double>& rect_, const WallType& wallType)
-		: SpriteActor(textureManager.get(wallType.textureName, true), wallType.defaultRect), collidableBounds(false)
+	static Entity spawn(const Rect<double>& rect, const WallType& wallType)
 	{
-		
-		setPosition(rect_.position);
-		setSize(rect_.size);
-		if(autoOffsetWallTexture){
-            setOffset(rect_.position);
-		}
+	    sf::Sprite sprite(textureManager.get(wallType.textureName, true), wallType.defaultRect);
+	    sprite.setPosition(rect.position);
+	    const Vector2i size   = rect.size;
+	    const Vector2i offset = autoOffsetWallTexture ? Vector2i(rect.position) : Vector2i(wallType.defaultRect.left, wallType.defaultRect.top);
+	    sprite.setTextureRect(sf::IntRect(offset.x, offset.y, size.x, size.y));
+	    
+	    invalidate();
+	    return rooms.create(Components::Bounds{Rect<double>(Vector2d(sprite.getPosition()), Vector2d(size))}, Components::Sprite{sprite});
 	}
-	Room(const Rect<double>& rect_, const WallType& wallType, std::vector<Platform>& platformsCollection)
-		: SpriteActor(textureManager.get(wallType.textureName, true), wallType.defaultRect), collidableBounds(false)
+	// Also adds the platforms along the room's walls
+	static Entity spawn(const Rect<double>& rect, const WallType& wallType, std::vector<Platform>& platformsCollection)
 	{
-		setPosition(rect_.position);
-		setSize(rect_.size);
-		
-		if(autoOffsetWallTexture){
-            setOffset(rect_.position);
-		}
-		
-		Rect<double> tempRect = getRect();
+	    Entity room = spawn(rect, wallType);
+	    
+	    Rect<double> tempRect = rooms.get<Components::Bounds>(room)->value;
         platformsCollection.emplace_back(tempRect.getUpperLeft(),  tempRect.size.x, false);
         platformsCollection.emplace_back(tempRect.getBottomLeft(), tempRect.size.x, false);
         platformsCollection.emplace_back(tempRect.getUpperLeft(),  tempRect.size.y, true);
         platformsCollection.emplace_back(tempRect.getUpperRight(), tempRect.size.y, true);
-		
+        return room;
+	}
+	
+	static bool despawn(const Entity& room)
+	{
+	    invalidate();
+	    return rooms.destroy(room);
+	}
+	static void despawnAll()
+	{
+	    invalidate();
+	    rooms.clear();
 	}
 	
+	// Called at level load; otherwise the first query after a change builds it
+	static void buildBVH()
+	{
+	    std::vector<Rect<double> > boxes;
+	    boxes.reserve(rooms.size());
+	    for(const Components::Bounds& bounds : rooms.getColumn<Components::Bounds>())
+        {
+            boxes.push_back(bounds.value);
+        }
+        bvh.build(boxes);
+	}
 	
-	virtual ~Room(){}
+	// Called at level load; otherwise the first frame after a change bakes it
+	static void bakeMesh()
+	{
+	    std::shared_ptr<StaticMesh> baked = std::make_shared<StaticMesh>();
+	    for(const Components::Sprite& sprite : rooms.getColumn<Components::Sprite>())
+        {
+            baked->addSprite(sprite.value);
+        }
+        mesh = baked;
+	}
+	
+	static std::shared_ptr<const StaticMesh> getMesh()
+	{
+	    if(!mesh)
+        {
+            bakeMesh();
+        }
+        return mesh;
+	}
+	
+	// Box around all the rooms
+	static Rect<double> getBounds()
+	{
+	    if(rooms.empty())
+        {
+            return Rect<double>(0, 0, 0, 0);
+        }
+        if(!bvh.isBuilt())
+        {
+            buildBVH();
+        }
+        return bvh.getBounds();
+	}
+	
+	static bool isPointInside(const Vector2d& point)
+	{
+	    if(rooms.empty())
+        {
+            return false;
+        }
+        if(!bvh.isBuilt())
+        {
+            buildBVH();
+        }
+	    const std::vector<Components::Bounds>& boxes = rooms.getColumn<Components::Bounds>();
+        return bvh.queryPoint(point, [&point, &boxes](unsigned int index)
+        {
+            return CollisionFast::test(point, boxes[index].value);
+        });
+	}
+	
+	static void captureAll(RenderSnapshot& snapshot)
+	{
+	    snapshot.staticMesh = getMesh();
+	}
+	
+	// Rooms never move, so there is nothing to interpolate
+	static void drawAll(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default)
+	{
+	    getMesh()->draw(target, Culling::getViewRect(target.getView()), states);
+	}
 	
 };
 
 bool Room::autoOffsetWallTexture = true;
+StaticBVH Room::bvh;
+Room::Rooms Room::rooms;
+std::shared_ptr<const StaticMesh> Room::mesh;
 
 #endif // ROOM_HPP_INCLUDED
@@ -2,6 +2,10 @@
 #define SHAPES_HPP_INCLUDED
 
 #include "Vectors.hpp"
+#include "SmallVector.hpp"
+
+template<class T>
+class Rect;
 
 class Projectable
 {
@@ -37,6 +41,11 @@ public:
     	return Vector2<T>(position.y - radius, position.y + radius);
     }
     
+    Rect<T> getBoundingRect() const
+    {
+        return Rect<T>(position.x - radius, position.y - radius, radius * 2, radius * 2);
+    }
+    
     virtual Vector2d getProjectionRange(const Vector2d& axis) const
     {
         double centerProjection = axis.dot(position);
@@ -82,6 +91,12 @@ public:
         point1.rotateSelf(angle);
         point2.rotateSelf(angle);
         return *this;
+    }
+    Line<T>& rotateSelf(double cosAngle, double sinAngle)
+    {
+        point1.rotateSelf(cosAngle, sinAngle);
+        point2.rotateSelf(cosAngle, sinAngle);
+        return *this;
     }    
     
     Vector2<T> toVector() const
@@ -97,6 +112,11 @@ public:
         return toVector().magnatudeSquared();
     }
     
+    Rect<T> getBoundingRect() const
+    {
+        return Rect<T>(std::min(point1.x, point2.x), std::min(point1.y, point2.y), std::abs(point2.x - point1.x), std::abs(point2.y - point1.y));
+    }
+    
     virtual Vector2d getProjectionRange(const Vector2d& axis) const
     {
         return Vector2d(axis.dot(point1), axis.dot(point2));
@@ -124,12 +144,14 @@ public:
 };
 
 
-template <typename T>
+// Points are kept inside the polygon up to InlineCapacity, so copying the usual
+// small collider polygons doesn't allocate
+template <typename T, unsigned int InlineCapacity = 8>
 class Polygon : public Projectable
 {
 public:
     bool isConvex = false;
-    std::vector<Vector2<T> > points;
+    SmallVector<Vector2<T>, InlineCapacity> points;
     
     const Vector2<T>& getPoint(unsigned int i) const
     {
@@ -180,7 +202,7 @@ public:
     
     void reset()
     {
-        points.erase(points.begin(), points.end());
+        points.clear();
     }
     
     
@@ -189,6 +211,24 @@ public:
         return points.size() > 2;
     }
     
+    Rect<T> getBoundingRect() const
+    {
+        if(points.size() < 1)
+        {
+            return Rect<T>(0, 0, 0, 0);
+        }
+        Vector2<T> mn = points[0];
+        Vector2<T> mx = points[0];
+        for(const auto& point : points)
+        {
+            mn.x = std::min(mn.x, point.x);
+            mn.y = std::min(mn.y, point.y);
+            mx.x = std::max(mx.x, point.x);
+            mx.y = std::max(mx.y, point.y);
+        }
+        return Rect<T>(mn, mx - mn);
+    }
+    
     bool checkConvex()
     {
         double direction = 0;
@@ -226,10 +266,14 @@ public:
         return *this;
     }
     Polygon<T>& rotateSelf(double angle)
+    {
+        return rotateSelf(std::cos(toRadians(angle)), std::sin(toRadians(angle)));
+    }
+    Polygon<T>& rotateSelf(double cosAngle, double sinAngle)
     {
         for(auto& point : points)
         {
-            point.rotateSelf(angle);
+            point.rotateSelf(cosAngle, sinAngle);
         }
         return *this;
     }
@@ -342,6 +386,11 @@ public:
 		return Vector2<T>(position.x, position.x + size.x);
 	}
 	
+	Rect<T> getBoundingRect() const
+	{
+	    return *this;
+	}
+	
 	Rect<T> rotate(int rotations) const
 	{
 	    rotations %= 4;
@@ -477,6 +526,11 @@ public:
 	    return Line<T>(position, getEnd());
 	}
 	
+	Rect<T> getBoundingRect() const
+	{
+	    return Rect<T>(position, getVector());
+	}
+	
 	Rect<T> toRect() const
 	{
 		if(isVertical)
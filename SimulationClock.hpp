@@ -0,0 +1,65 @@
+#ifndef SIMULATIONCLOCK_HPP_INCLUDED
+#define SIMULATIONCLOCK_HPP_INCLUDED
+
+#include <algorithm>
+
+// Turns variable frame times into a whole number of fixed simulation steps.
+// Leftover time is carried to the next frame; when a frame would need more
+// than maxSteps the rest is dropped, so a hitch slows the game down for a
+// moment instead of feeding the physics one huge step.
+class SimulationClock
+{
+    double          step;
+    unsigned int    maxSteps;
+    double          accumulator;
+    unsigned int    droppedSteps;
+
+public:
+
+    // Returns the number of steps to simulate this frame
+    unsigned int advance(double frameTime)
+    {
+        accumulator += std::max(frameTime, 0.0);
+        unsigned int steps = static_cast<unsigned int>(accumulator / step);
+        if(steps > maxSteps)
+        {
+            droppedSteps += steps - maxSteps;
+            steps = maxSteps;
+            accumulator = 0;
+        }
+        else
+        {
+            accumulator -= steps * step;
+        }
+        return steps;
+    }
+
+    double getStep() const
+    {
+        return step;
+    }
+
+    // How far the frame is between the last two simulated states, 0 to 1
+    double getInterpolation() const
+    {
+        return std::min(accumulator / step, 1.0);
+    }
+
+    // Time left until advance() has the next step to hand out
+    double getTimeToNextStep() const
+    {
+        return std::max(step - accumulator, 0.0);
+    }
+
+    // Steps skipped because of the per frame cap, since the clock was created
+    unsigned int getDroppedSteps() const
+    {
+        return droppedSteps;
+    }
+
+    SimulationClock(double step_ = 1.0 / 120, unsigned int maxSteps_ = 5)
+        : step(step_), maxSteps(maxSteps_), accumulator(0), droppedSteps(0)
+    {}
+};
+
+#endif // SIMULATIONCLOCK_HPP_INCLUDED
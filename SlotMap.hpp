@@ -0,0 +1,226 @@
+#ifndef SLOTMAP_HPP_INCLUDED
+#define SLOTMAP_HPP_INCLUDED
+
+#include <vector>
+
+// Names a slot and the generation the slot had when it was handed out.
+// TTag only keeps handles of different containers apart.
+template<class TTag>
+struct GenerationalHandle
+{
+    static constexpr unsigned int nullIndex = ~0u;
+
+    unsigned int index      = nullIndex;
+    unsigned int generation = 0;
+
+    // Only tells whether the handle was ever set, not whether it is still valid
+    explicit operator bool() const
+    {
+        return index != nullIndex;
+    }
+
+    bool operator==(const GenerationalHandle<TTag>& other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const GenerationalHandle<TTag>& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+template<class TTag>
+constexpr unsigned int GenerationalHandle<TTag>::nullIndex;
+
+// Maps handles to indices into densely packed arrays kept by the owner.
+// Erasing bumps the slot's generation, so a handle to an erased element stays
+// detectably stale even after its slot is reused. The owner has to move its
+// last element into the erased index, as the table does with its own records.
+template<class TTag>
+class SlotTable
+{
+public:
+
+    typedef GenerationalHandle<TTag> Handle;
+
+private:
+
+    struct Slot
+    {
+        unsigned int denseIndex;
+        unsigned int generation;
+    };
+
+    std::vector<unsigned int>   denseSlots;
+    std::vector<Slot>           slots;
+    std::vector<unsigned int>   freeSlots;
+
+public:
+
+    unsigned int size() const
+    {
+        return denseSlots.size();
+    }
+
+    bool contains(const Handle& handle) const
+    {
+        return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+    }
+
+    // Only for valid handles
+    unsigned int getIndex(const Handle& handle) const
+    {
+        return slots[handle.index].denseIndex;
+    }
+
+    Handle getHandle(unsigned int denseIndex) const
+    {
+        Handle handle;
+        handle.index      = denseSlots[denseIndex];
+        handle.generation = slots[handle.index].generation;
+        return handle;
+    }
+
+    // The new element goes to index size() - 1
+    Handle insert()
+    {
+        unsigned int slot;
+        if(freeSlots.empty())
+        {
+            slot = slots.size();
+            slots.push_back(Slot{0, 0});
+        }
+        else
+        {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        slots[slot].denseIndex = denseSlots.size();
+        denseSlots.push_back(slot);
+        return getHandle(denseSlots.size() - 1);
+    }
+
+    // Returns false if the handle was already stale. Otherwise index is
+    // where the element was; the last element now belongs there.
+    bool erase(const Handle& handle, unsigned int& index)
+    {
+        if(!contains(handle))
+        {
+            return false;
+        }
+        Slot& slot = slots[handle.index];
+        index = slot.denseIndex;
+        unsigned int last = denseSlots.size() - 1;
+        if(index != last)
+        {
+            denseSlots[index]                  = denseSlots[last];
+            slots[denseSlots[index]].denseIndex = index;
+        }
+        denseSlots.pop_back();
+        slot.generation++;
+        freeSlots.push_back(handle.index);
+        return true;
+    }
+
+    // Every handle given out so far becomes stale
+    void clear()
+    {
+        for(unsigned int slot : denseSlots)
+        {
+            slots[slot].generation++;
+            freeSlots.push_back(slot);
+        }
+        denseSlots.clear();
+    }
+};
+
+// Pointers kept densely packed for iteration, reached from the outside through
+// handles. Insert, erase and lookup are O(1); erasing moves the last element
+// into the gap, so the iteration order changes. Owns nothing, the pointers
+// aren't deleted.
+template<class T>
+class SlotMap
+{
+public:
+
+    typedef GenerationalHandle<SlotMap<T> > Handle;
+
+private:
+
+    std::vector<T*>             elements;
+    SlotTable<SlotMap<T> >      table;
+
+public:
+
+    typedef typename std::vector<T*>::const_iterator const_iterator;
+
+    unsigned int size() const
+    {
+        return elements.size();
+    }
+
+    bool empty() const
+    {
+        return elements.empty();
+    }
+
+    // Dense index, 0 to size()
+    T* operator[](unsigned int i) const
+    {
+        return elements[i];
+    }
+
+    const_iterator begin() const
+    {
+        return elements.begin();
+    }
+
+    const_iterator end() const
+    {
+        return elements.end();
+    }
+
+    Handle getHandle(unsigned int denseIndex) const
+    {
+        return table.getHandle(denseIndex);
+    }
+
+    bool contains(const Handle& handle) const
+    {
+        return table.contains(handle);
+    }
+
+    // nullptr for a stale or null handle
+    T* get(const Handle& handle) const
+    {
+        return table.contains(handle) ? elements[table.getIndex(handle)] : nullptr;
+    }
+
+    Handle insert(T* element)
+    {
+        elements.push_back(element);
+        return table.insert();
+    }
+
+    // Returns false if the handle was already stale
+    bool erase(const Handle& handle)
+    {
+        unsigned int index;
+        if(!table.erase(handle, index))
+        {
+            return false;
+        }
+        elements[index] = elements.back();
+        elements.pop_back();
+        return true;
+    }
+
+    // Every handle given out so far becomes stale
+    void clear()
+    {
+        elements.clear();
+        table.clear();
+    }
+};
+
+#endif // SLOTMAP_HPP_INCLUDED
@@ -0,0 +1,186 @@
+#ifndef SMALLVECTOR_HPP_INCLUDED
+#define SMALLVECTOR_HPP_INCLUDED
+
+#include <cstddef>
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <initializer_list>
+#include <utility>
+
+// Vector keeping up to InlineCapacity elements inside the object itself.
+// Only when it grows past that the elements move to the heap, so small
+// containers never allocate. Covers the part of std::vector the shapes use.
+template<class T, unsigned int InlineCapacity>
+class SmallVector
+{
+    typename std::aligned_storage<sizeof(T) * InlineCapacity, alignof(T)>::type inlineStorage;
+
+    T*          elements;
+    std::size_t count;
+    std::size_t capacity;
+
+    T* getInlineElements()
+    {
+        return reinterpret_cast<T*>(&inlineStorage);
+    }
+
+    bool isInline() const
+    {
+        return elements == reinterpret_cast<const T*>(&inlineStorage);
+    }
+
+    void grow(std::size_t minimalCapacity)
+    {
+        std::size_t newCapacity = capacity * 2;
+        if(newCapacity < minimalCapacity)
+        {
+            newCapacity = minimalCapacity;
+        }
+        T* newElements = static_cast<T*>(::operator new(newCapacity * sizeof(T)));
+        for(std::size_t i=0; i<count; i++)
+        {
+            new (newElements + i) T(std::move(elements[i]));
+            elements[i].~T();
+        }
+        if(!isInline())
+        {
+            ::operator delete(elements);
+        }
+        elements = newElements;
+        capacity = newCapacity;
+    }
+
+    void release()
+    {
+        clear();
+        if(!isInline())
+        {
+            ::operator delete(elements);
+            elements = getInlineElements();
+            capacity = InlineCapacity;
+        }
+    }
+
+public:
+
+    typedef T           value_type;
+    typedef T*          iterator;
+    typedef const T*    const_iterator;
+
+    std::size_t size() const            {return count;}
+    bool        empty() const           {return count == 0;}
+    std::size_t getCapacity() const     {return capacity;}
+    bool        isOnHeap() const        {return !isInline();}
+
+    T&       operator[](std::size_t i)          {return elements[i];}
+    const T& operator[](std::size_t i) const    {return elements[i];}
+
+    T&       back()         {return elements[count-1];}
+    const T& back() const   {return elements[count-1];}
+
+    iterator        begin()         {return elements;}
+    iterator        end()           {return elements + count;}
+    const_iterator  begin() const   {return elements;}
+    const_iterator  end() const     {return elements + count;}
+
+    void reserve(std::size_t newCapacity)
+    {
+        if(newCapacity > capacity)
+        {
+            grow(newCapacity);
+        }
+    }
+
+    void push_back(const T& value)
+    {
+        if(count == capacity)
+        {
+            T copy(value);
+            grow(count + 1);
+            new (elements + count) T(std::move(copy));
+        }
+        else
+        {
+            new (elements + count) T(value);
+        }
+        count++;
+    }
+
+    void pop_back()
+    {
+        elements[--count].~T();
+    }
+
+    // Appends the range, then rotates it into place; the range must not come from this vector
+    template<class TIterator>
+    iterator insert(iterator position, TIterator first, TIterator last)
+    {
+        std::size_t offset   = position - elements;
+        std::size_t oldCount = count;
+        for(; first != last; ++first)
+        {
+            push_back(*first);
+        }
+        std::rotate(elements + offset, elements + oldCount, elements + count);
+        return elements + offset;
+    }
+
+    iterator erase(iterator first, iterator last)
+    {
+        std::size_t removed = last - first;
+        iterator out = first;
+        for(iterator it = last; it != end(); ++it, ++out)
+        {
+            *out = std::move(*it);
+        }
+        for(iterator it = out; it != end(); ++it)
+        {
+            it->~T();
+        }
+        count -= removed;
+        return first;
+    }
+
+    void clear()
+    {
+        for(std::size_t i=0; i<count; i++)
+        {
+            elements[i].~T();
+        }
+        count = 0;
+    }
+
+    SmallVector()
+        : elements(getInlineElements()), count(0), capacity(InlineCapacity)
+    {}
+
+    SmallVector(std::initializer_list<T> list)
+        : SmallVector()
+    {
+        insert(end(), list.begin(), list.end());
+    }
+
+    SmallVector(const SmallVector& v)
+        : SmallVector()
+    {
+        insert(end(), v.begin(), v.end());
+    }
+
+    SmallVector& operator=(const SmallVector& v)
+    {
+        if(this != &v)
+        {
+            clear();
+            insert(end(), v.begin(), v.end());
+        }
+        return *this;
+    }
+
+    ~SmallVector()
+    {
+        release();
+    }
+};
+
+#endif // SMALLVECTOR_HPP_INCLUDED
@@ -0,0 +1,184 @@
+#ifndef SPRITEBATCH_HPP_INCLUDED
+#define SPRITEBATCH_HPP_INCLUDED
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "Vectors.hpp"
+#include "Culling.hpp"
+
+// Collects textured quads and draws them with one draw call per texture.
+// The vertex buffers are kept between frames, so once they have grown to
+// the frame's size adding quads doesn't allocate.
+// Quads of the same texture keep their order, but a texture is drawn after
+// all the textures added before it, so quads overlapping across textures
+// should go to different batches if their order matters.
+// With a cull rect set, quads outside of it are dropped when they are added.
+class SpriteBatch
+{
+    struct Layer
+    {
+        const sf::Texture*      texture;
+        std::vector<sf::Vertex> vertices;
+    };
+
+    std::vector<Layer>  layers;
+    unsigned int        usedLayers;
+
+    bool                isCulling;
+    Rect<double>        cullRect;
+    unsigned int        culled;
+    unsigned int        submitted;
+
+    std::vector<sf::Vertex>& getVertices(const sf::Texture* texture)
+    {
+        for(unsigned int i=0; i<usedLayers; i++)
+        {
+            if(layers[i].texture == texture)
+            {
+                return layers[i].vertices;
+            }
+        }
+        if(usedLayers == layers.size())
+        {
+            layers.push_back(Layer());
+        }
+        Layer& layer = layers[usedLayers++];
+        layer.texture = texture;
+        return layer.vertices;
+    }
+
+public:
+
+    // The quad covers the texture rect's size in local coordinates; a negative
+    // width or height flips it, as it does for sf::Sprite
+    void add(const sf::Texture* texture, const sf::Transform& transform, const sf::IntRect& textureRect, const sf::Color& color = sf::Color::White)
+    {
+        const float width  = std::abs(textureRect.width);
+        const float height = std::abs(textureRect.height);
+        const float left   = textureRect.left;
+        const float right  = textureRect.left + textureRect.width;
+        const float top    = textureRect.top;
+        const float bottom = textureRect.top  + textureRect.height;
+
+        const sf::Vector2f corners[4] = {transform.transformPoint(0, 0),          transform.transformPoint(width, 0),
+                                         transform.transformPoint(width, height), transform.transformPoint(0, height)};
+        if(isCulling)
+        {
+            sf::Vector2f topLeft = corners[0], bottomRight = corners[0];
+            for(const sf::Vector2f& corner : corners)
+            {
+                topLeft.x     = std::min(topLeft.x, corner.x);
+                topLeft.y     = std::min(topLeft.y, corner.y);
+                bottomRight.x = std::max(bottomRight.x, corner.x);
+                bottomRight.y = std::max(bottomRight.y, corner.y);
+            }
+            if(!Culling::isVisible(Rect<double>(Vector2d(topLeft), Vector2d(bottomRight - topLeft)), cullRect))
+            {
+                culled++;
+                return;
+            }
+        }
+        submitted++;
+
+        std::vector<sf::Vertex>& vertices = getVertices(texture);
+        vertices.push_back(sf::Vertex(corners[0], color, sf::Vector2f(left,  top)));
+        vertices.push_back(sf::Vertex(corners[1], color, sf::Vector2f(right, top)));
+        vertices.push_back(sf::Vertex(corners[2], color, sf::Vector2f(right, bottom)));
+        vertices.push_back(sf::Vertex(corners[3], color, sf::Vector2f(left,  bottom)));
+    }
+
+    void add(const sf::Texture* texture, const Transform& transform, const Vector2d& origin, sf::IntRect textureRect, bool flipX = false, bool flipY = false)
+    {
+        if(flipX)
+        {
+            textureRect.left  += textureRect.width;
+            textureRect.width  = -textureRect.width;
+        }
+        if(flipY)
+        {
+            textureRect.top    += textureRect.height;
+            textureRect.height  = -textureRect.height;
+        }
+        sf::Transform placed;
+        placed.translate(transform.position.x, transform.position.y);
+        placed.rotate(transform.rotation);
+        placed.scale(transform.scale.x, transform.scale.y);
+        placed.translate(-origin.x, -origin.y);
+        add(texture, placed, textureRect);
+    }
+
+    // The sprite as it would be drawn, moved by offset and turned by rotation
+    // more degrees around its origin
+    void add(const sf::Sprite& sprite, const Vector2d& offset = Vectors::null, double rotation = 0)
+    {
+        sf::Transform placed;
+        placed.translate(offset.x, offset.y);
+        if(rotation != 0)
+        {
+            placed.rotate(rotation, sprite.getPosition().x, sprite.getPosition().y);
+        }
+        placed.combine(sprite.getTransform());
+        add(sprite.getTexture(), placed, sprite.getTextureRect(), sprite.getColor());
+    }
+
+    // Usually Culling::getViewRect of the target the batch is flushed to
+    void setCullRect(const Rect<double>& rect)
+    {
+        isCulling = true;
+        cullRect  = rect;
+    }
+    void removeCullRect()
+    {
+        isCulling = false;
+    }
+
+    unsigned int getQuadsCount() const
+    {
+        unsigned int count = 0;
+        for(unsigned int i=0; i<usedLayers; i++)
+        {
+            count += layers[i].vertices.size() / 4;
+        }
+        return count;
+    }
+
+    // Draws everything added since the last flush, one draw call per texture,
+    // and empties the batch. The culling counts go to Culling.
+    void flush(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default)
+    {
+        Culling::count(culled, submitted);
+        culled    = 0;
+        submitted = 0;
+        sf::RenderStates textured(states);
+        for(unsigned int i=0; i<usedLayers; i++)
+        {
+            Layer& layer = layers[i];
+            if(!layer.vertices.empty())
+            {
+                textured.texture = layer.texture;
+                target.draw(&layer.vertices[0], layer.vertices.size(), sf::Quads, textured);
+            }
+            layer.vertices.clear();
+        }
+        usedLayers = 0;
+    }
+
+    void clear()
+    {
+        culled    = 0;
+        submitted = 0;
+        for(unsigned int i=0; i<usedLayers; i++)
+        {
+            layers[i].vertices.clear();
+        }
+        usedLayers = 0;
+    }
+
+    SpriteBatch()
+        : usedLayers(0), isCulling(false), cullRect(0, 0, 0, 0), culled(0), submitted(0)
+    {}
+};
+
+#endif // SPRITEBATCH_HPP_INCLUDED
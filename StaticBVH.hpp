@@ -0,0 +1,292 @@
+#ifndef STATICBVH_HPP_INCLUDED
+#define STATICBVH_HPP_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include "Shapes.hpp"
+
+// Read-only bounding volume hierarchy over a fixed set of boxes (rooms, platforms).
+// Nodes are stored in one array in depth-first order: the left child of an inner
+// node is the next node, and "skip" points past the whole subtree, so queries walk
+// the array front to back without a stack or any pointers.
+// Handlers get the index the box had in build() and return true to stop the query.
+class StaticBVH
+{
+public:
+    struct Node
+    {
+        Rect<double>    bounds;
+        unsigned int    first;
+        unsigned int    count;
+        unsigned int    skip;
+
+        Node()
+            : bounds(0, 0, 0, 0), first(0), count(0), skip(0)
+        {}
+
+        bool isLeaf() const
+        {
+            return count > 0;
+        }
+    };
+
+    static constexpr unsigned int maxLeafSize = 4;
+
+private:
+
+    std::vector<Node>           nodes;
+    std::vector<unsigned int>   indices;
+    std::vector<Rect<double> >  boxes;
+
+    static Rect<double> merge(const Rect<double>& a, const Rect<double>& b)
+    {
+        double left   = std::min(a.position.x, b.position.x);
+        double top    = std::min(a.position.y, b.position.y);
+        double right  = std::max(a.position.x + a.size.x, b.position.x + b.size.x);
+        double bottom = std::max(a.position.y + a.size.y, b.position.y + b.size.y);
+        return Rect<double>(left, top, right - left, bottom - top);
+    }
+
+    static Vector2d getCenter(const Rect<double>& rect)
+    {
+        return rect.position + rect.size * 0.5;
+    }
+
+    unsigned int buildNode(unsigned int first, unsigned int count)
+    {
+        unsigned int nodeIndex = nodes.size();
+        nodes.push_back(Node());
+
+        Rect<double> bounds = boxes[indices[first]];
+        Rect<double> centers(getCenter(bounds), Vectors::null);
+        for(unsigned int i = first + 1; i < first + count; i++)
+        {
+            bounds  = merge(bounds, boxes[indices[i]]);
+            centers = merge(centers, Rect<double>(getCenter(boxes[indices[i]]), Vectors::null));
+        }
+        nodes[nodeIndex].bounds = bounds;
+
+        if(count <= maxLeafSize)
+        {
+            nodes[nodeIndex].first = first;
+            nodes[nodeIndex].count = count;
+        }
+        else
+        {
+            // Median split along the longer axis of the centers
+            bool splitX = centers.size.x >= centers.size.y;
+            unsigned int half = count / 2;
+            std::nth_element(indices.begin() + first, indices.begin() + first + half, indices.begin() + first + count,
+                [this, splitX](unsigned int a, unsigned int b)
+                {
+                    Vector2d ca = getCenter(boxes[a]);
+                    Vector2d cb = getCenter(boxes[b]);
+                    return splitX ? ca.x < cb.x : ca.y < cb.y;
+                });
+
+            buildNode(first, half);
+            buildNode(first + half, count - half);
+        }
+        nodes[nodeIndex].skip = nodes.size();
+        return nodeIndex;
+    }
+
+    static bool overlaps(const Rect<double>& a, const Rect<double>& b)
+    {
+        return  a.position.x <= b.position.x + b.size.x && b.position.x <= a.position.x + a.size.x &&
+                a.position.y <= b.position.y + b.size.y && b.position.y <= a.position.y + a.size.y;
+    }
+
+    static bool contains(const Rect<double>& a, const Vector2d& point)
+    {
+        return  a.position.x <= point.x && point.x <= a.position.x + a.size.x &&
+                a.position.y <= point.y && point.y <= a.position.y + a.size.y;
+    }
+
+    static bool overlaps(const Rect<double>& a, const Vector2d& center, double radius)
+    {
+        double dx = std::max(std::max(a.position.x - center.x, center.x - (a.position.x + a.size.x)), 0.0);
+        double dy = std::max(std::max(a.position.y - center.y, center.y - (a.position.y + a.size.y)), 0.0);
+        return dx*dx + dy*dy <= radius*radius;
+    }
+
+    // Slab test of origin + direction * t, t in [0, maxFraction], against the box
+    static bool overlaps(const Rect<double>& a, const Vector2d& origin, const Vector2d& direction, double maxFraction)
+    {
+        double tMin = 0;
+        double tMax = maxFraction;
+        const double o[2] = {origin.x, origin.y};
+        const double d[2] = {direction.x, direction.y};
+        const double mn[2] = {a.position.x, a.position.y};
+        const double mx[2] = {a.position.x + a.size.x, a.position.y + a.size.y};
+        for(int axis = 0; axis < 2; axis++)
+        {
+            if(d[axis] == 0)
+            {
+                if(o[axis] < mn[axis] || o[axis] > mx[axis])
+                {
+                    return false;
+                }
+                continue;
+            }
+            double t1 = (mn[axis] - o[axis]) / d[axis];
+            double t2 = (mx[axis] - o[axis]) / d[axis];
+            if(t1 > t2)
+            {
+                std::swap(t1, t2);
+            }
+            tMin = std::max(tMin, t1);
+            tMax = std::min(tMax, t2);
+            if(tMin > tMax)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<class TNodeTest, class THandler>
+    bool traverse(TNodeTest nodeTest, THandler handler) const
+    {
+        unsigned int i = 0;
+        while(i < nodes.size())
+        {
+            const Node& node = nodes[i];
+            if(!nodeTest(node.bounds))
+            {
+                i = node.skip;
+                continue;
+            }
+            if(node.isLeaf())
+            {
+                for(unsigned int j = node.first; j < node.first + node.count; j++)
+                {
+                    if(handler(indices[j]))
+                    {
+                        return true;
+                    }
+                }
+            }
+            i++;
+        }
+        return false;
+    }
+
+public:
+
+    void clear()
+    {
+        nodes.clear();
+        indices.clear();
+        boxes.clear();
+    }
+
+    bool isBuilt() const
+    {
+        return !nodes.empty();
+    }
+
+    const std::vector<Node>& getNodes() const
+    {
+        return nodes;
+    }
+
+    Rect<double> getBounds() const
+    {
+        if(nodes.empty())
+        {
+            return Rect<double>(0, 0, 0, 0);
+        }
+        return nodes[0].bounds;
+    }
+
+    void build(const std::vector<Rect<double> >& boxes_)
+    {
+        clear();
+        boxes = boxes_;
+        if(boxes.empty())
+        {
+            return;
+        }
+        indices.resize(boxes.size());
+        for(unsigned int i=0; i<indices.size(); i++)
+        {
+            indices[i] = i;
+        }
+        nodes.reserve(2 * boxes.size() / maxLeafSize + 1);
+        buildNode(0, indices.size());
+    }
+
+    const Rect<double>& getBox(unsigned int index) const
+    {
+        return boxes[index];
+    }
+
+    // Boxes containing the point
+    template<class THandler>
+    bool queryPoint(const Vector2d& point, THandler handler) const
+    {
+        return traverse([&point](const Rect<double>& bounds){return contains(bounds, point);}, [&](unsigned int index)
+        {
+            return contains(boxes[index], point) && handler(index);
+        });
+    }
+
+    // Boxes overlapping the area
+    template<class THandler>
+    bool queryRect(const Rect<double>& area, THandler handler) const
+    {
+        return traverse([&area](const Rect<double>& bounds){return overlaps(bounds, area);}, [&](unsigned int index)
+        {
+            return overlaps(boxes[index], area) && handler(index);
+        });
+    }
+
+    // Boxes closer to the center than radius
+    template<class THandler>
+    bool queryRadius(const Vector2d& center, double radius, THandler handler) const
+    {
+        return traverse([&](const Rect<double>& bounds){return overlaps(bounds, center, radius);}, [&](unsigned int index)
+        {
+            return overlaps(boxes[index], center, radius) && handler(index);
+        });
+    }
+
+    // All boxes crossed by the segment, in no particular order
+    template<class THandler>
+    bool raycastAll(const Line<double>& segment, THandler handler) const
+    {
+        Vector2d direction = segment.toVector();
+        return traverse([&](const Rect<double>& bounds){return overlaps(bounds, segment.point1, direction, 1);}, [&](unsigned int index)
+        {
+            return overlaps(boxes[index], segment.point1, direction, 1) && handler(index);
+        });
+    }
+
+    // Closest hit along the segment. intersect(index, fraction) does the exact test
+    // for a candidate and stores the hit position as a fraction of the segment.
+    // Subtrees starting past the best hit found so far are skipped.
+    template<class TIntersect>
+    bool raycast(const Line<double>& segment, TIntersect intersect, unsigned int& hitIndex, double& hitFraction) const
+    {
+        Vector2d direction = segment.toVector();
+        bool hit = false;
+        hitFraction = 1;
+        traverse([&](const Rect<double>& bounds){return overlaps(bounds, segment.point1, direction, hitFraction);}, [&](unsigned int index)
+        {
+            double fraction;
+            if(intersect(index, fraction) && fraction <= hitFraction)
+            {
+                hit         = true;
+                hitIndex    = index;
+                hitFraction = fraction;
+            }
+            return false;
+        });
+        return hit;
+    }
+};
+
+constexpr unsigned int StaticBVH::maxLeafSize;
+
+#endif // STATICBVH_HPP_INCLUDED
@@ -0,0 +1,122 @@
+#ifndef STATICMESH_HPP_INCLUDED
+#define STATICMESH_HPP_INCLUDED
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "Vectors.hpp"
+#include "Shapes.hpp"
+#include "Culling.hpp"
+
+// Geometry that never moves, baked into one vertex array per texture and
+// chunk of the world, so all of it is drawn with one draw call per texture
+// and visible chunk. A quad goes to the chunk of its upper left corner and
+// the chunk's bounds grow to cover it, so big quads are never cut.
+// Quads are axis aligned; a texture rect bigger than its texture tiles it if
+// the texture is repeated.
+// Nothing is updated in place: a changed level is baked into a new mesh.
+class StaticMesh
+{
+    struct Layer
+    {
+        const sf::Texture*  texture;
+        Vector2i            chunk;
+        Rect<double>        bounds;
+        sf::VertexArray     vertices;
+    };
+
+    std::vector<Layer>  layers;
+    double              chunkSize;
+
+    Layer& getLayer(const sf::Texture* texture, const Rect<double>& rect)
+    {
+        const Vector2i chunk(std::floor(rect.position.x / chunkSize), std::floor(rect.position.y / chunkSize));
+        for(Layer& layer : layers)
+        {
+            if(layer.texture == texture && layer.chunk.x == chunk.x && layer.chunk.y == chunk.y)
+            {
+                const Vector2d topLeft(std::min(layer.bounds.position.x, rect.position.x), std::min(layer.bounds.position.y, rect.position.y));
+                const Vector2d bottomRight(std::max(layer.bounds.position.x + layer.bounds.size.x, rect.position.x + rect.size.x),
+                                           std::max(layer.bounds.position.y + layer.bounds.size.y, rect.position.y + rect.size.y));
+                layer.bounds = Rect<double>(topLeft, bottomRight - topLeft);
+                return layer;
+            }
+        }
+        layers.push_back(Layer{texture, chunk, rect, sf::VertexArray(sf::Quads)});
+        return layers.back();
+    }
+
+public:
+
+    void addQuad(const sf::Texture* texture, const Rect<double>& rect, const sf::IntRect& textureRect)
+    {
+        sf::VertexArray& vertices = getLayer(texture, rect).vertices;
+        const sf::Vector2f position(rect.position.x, rect.position.y);
+        const sf::Vector2f size(rect.size.x, rect.size.y);
+        const sf::Vector2f texturePosition(textureRect.left, textureRect.top);
+        const sf::Vector2f textureSize(textureRect.width, textureRect.height);
+        vertices.append(sf::Vertex(position,                                  texturePosition));
+        vertices.append(sf::Vertex(position + sf::Vector2f(size.x, 0),        texturePosition + sf::Vector2f(textureSize.x, 0)));
+        vertices.append(sf::Vertex(position + size,                           texturePosition + textureSize));
+        vertices.append(sf::Vertex(position + sf::Vector2f(0, size.y),        texturePosition + sf::Vector2f(0, textureSize.y)));
+    }
+
+    // Bakes the sprite as it is placed now; rotation and scale are ignored
+    void addSprite(const sf::Sprite& sprite)
+    {
+        const sf::IntRect& textureRect = sprite.getTextureRect();
+        addQuad(sprite.getTexture(), Rect<double>(Vector2d(sprite.getPosition()), Vector2d(textureRect.width, textureRect.height)), textureRect);
+    }
+
+    void clear()
+    {
+        layers.clear();
+    }
+
+    // Draw calls draw() makes at most
+    unsigned int getLayersCount() const
+    {
+        return layers.size();
+    }
+
+    unsigned int getQuadsCount() const
+    {
+        unsigned int count = 0;
+        for(const Layer& layer : layers)
+        {
+            count += layer.vertices.getVertexCount() / 4;
+        }
+        return count;
+    }
+
+    void draw(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default) const
+    {
+        sf::RenderStates textured(states);
+        for(const Layer& layer : layers)
+        {
+            textured.texture = layer.texture;
+            target.draw(layer.vertices, textured);
+        }
+    }
+
+    // Only the chunks intersecting the view, counted in Culling
+    void draw(sf::RenderTarget& target, const Rect<double>& view, const sf::RenderStates& states = sf::RenderStates::Default) const
+    {
+        sf::RenderStates textured(states);
+        for(const Layer& layer : layers)
+        {
+            if(Culling::test(layer.bounds, view))
+            {
+                textured.texture = layer.texture;
+                target.draw(layer.vertices, textured);
+            }
+        }
+    }
+
+    StaticMesh(double chunkSize_ = 512)
+        : chunkSize(chunkSize_)
+    {}
+};
+
+#endif // STATICMESH_HPP_INCLUDED
@@ -0,0 +1,158 @@
+#ifndef TASKGRAPH_HPP_INCLUDED
+#define TASKGRAPH_HPP_INCLUDED
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include "JobSystem.hpp"
+
+// The stages of a frame and what each of them waits for. Built once and run
+// every frame: a task starts as soon as all its dependencies are done, tasks
+// without a path between them run at the same time on the job system.
+// Tasks touching the window (SFML drawing) are marked to run on the thread
+// calling run().
+class TaskGraph
+{
+    struct Task
+    {
+        std::string                 name;
+        std::function<void()>       function;
+        bool                        onCallingThread;
+        std::vector<unsigned int>   dependents;
+        unsigned int                dependenciesCount;
+        std::atomic<unsigned int>   dependenciesLeft;
+        // Written by the thread running the task, read by anyone asking for the timings
+        std::atomic<double>         milliseconds;
+
+        Task(const std::string& name_, const std::function<void()>& function_, bool onCallingThread_)
+            : name(name_), function(function_), onCallingThread(onCallingThread_), dependenciesCount(0), dependenciesLeft(0), milliseconds(0)
+        {}
+    };
+
+    std::vector<std::unique_ptr<Task> > tasks;
+
+    std::mutex                  callingThreadMutex;
+    std::deque<unsigned int>    callingThreadReady;
+    std::atomic<unsigned int>   tasksLeft;
+    std::atomic<unsigned int>   jobsCounter;
+
+    void execute(unsigned int index, JobSystem& jobs)
+    {
+        Task& task = *tasks[index];
+        auto start = std::chrono::steady_clock::now();
+        task.function();
+        auto end = std::chrono::steady_clock::now();
+        task.milliseconds.store(std::chrono::duration<double, std::milli>(end - start).count(), std::memory_order_relaxed);
+
+        for(unsigned int dependent : task.dependents)
+        {
+            if(--tasks[dependent]->dependenciesLeft == 0)
+            {
+                schedule(dependent, jobs);
+            }
+        }
+        tasksLeft--;
+    }
+
+    void schedule(unsigned int index, JobSystem& jobs)
+    {
+        if(tasks[index]->onCallingThread)
+        {
+            std::lock_guard<std::mutex> lock(callingThreadMutex);
+            callingThreadReady.push_back(index);
+        }
+        else
+        {
+            jobs.submit([this, index, &jobs]{execute(index, jobs);}, jobsCounter);
+        }
+    }
+
+    bool popCallingThreadTask(unsigned int& index)
+    {
+        std::lock_guard<std::mutex> lock(callingThreadMutex);
+        if(callingThreadReady.empty())
+        {
+            return false;
+        }
+        index = callingThreadReady.front();
+        callingThreadReady.pop_front();
+        return true;
+    }
+
+public:
+
+    // Returns the task id used for dependencies and timings
+    unsigned int addTask(const std::string& name, const std::function<void()>& function, bool onCallingThread = false)
+    {
+        tasks.emplace_back(new Task(name, function, onCallingThread));
+        return tasks.size() - 1;
+    }
+
+    // "after" starts only once "before" is done
+    void addDependency(unsigned int before, unsigned int after)
+    {
+        tasks[before]->dependents.push_back(after);
+        tasks[after]->dependenciesCount++;
+    }
+
+    // Returns when every task is done. The calling thread runs its own tasks
+    // and helps with the others in the meantime.
+    void run(JobSystem& jobs = jobSystem)
+    {
+        tasksLeft = tasks.size();
+        for(auto& task : tasks)
+        {
+            task->dependenciesLeft = task->dependenciesCount;
+        }
+        for(unsigned int i=0; i<tasks.size(); i++)
+        {
+            if(tasks[i]->dependenciesCount == 0)
+            {
+                schedule(i, jobs);
+            }
+        }
+        while(tasksLeft > 0)
+        {
+            unsigned int index;
+            if(popCallingThreadTask(index))
+            {
+                execute(index, jobs);
+            }
+            else if(!jobs.runPendingJob())
+            {
+                std::this_thread::yield();
+            }
+        }
+        jobs.wait(jobsCounter);
+    }
+
+    unsigned int getTasksCount() const
+    {
+        return tasks.size();
+    }
+
+    const std::string& getName(unsigned int task) const
+    {
+        return tasks[task]->name;
+    }
+
+    // Wall time of the task in its last finished run. Safe to call from
+    // another thread while the graph runs; the tasks' timings may then come
+    // from different runs.
+    double getMilliseconds(unsigned int task) const
+    {
+        return tasks[task]->milliseconds.load(std::memory_order_relaxed);
+    }
+
+    TaskGraph()
+        : tasksLeft(0), jobsCounter(0)
+    {}
+};
+
+#endif // TASKGRAPH_HPP_INCLUDED
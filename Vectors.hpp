@@ -189,6 +189,7 @@ public:
     Vector2<T>& normalizeSelf();
     Vector2<T> rotate(double angle) const;
     Vector2<T>& rotateSelf(double angle);
+    Vector2<T>& rotateSelf(double cosAngle, double sinAngle);
     
     
     
@@ -280,6 +281,15 @@ Vector2<T>& Vector2<T>::rotateSelf(double angle)
     return *this;
 }
 
+template<typename T>
+Vector2<T>& Vector2<T>::rotateSelf(double cosAngle, double sinAngle)
+{
+    auto tx = x;
+    x = cosAngle*x-sinAngle*y;
+    y = cosAngle*y+sinAngle*tx;
+    return *this;
+}
+
 template<typename T>
 Vector2<T> operator*(T s, const Vector2<T>& v)
 {
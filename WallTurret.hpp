@@ -3,167 +3,280 @@
 
 #include "TextureManager.hpp"
 #include "Object.hpp"
+#include "Archetype.hpp"
+#include "Components.hpp"
 
 
-class WallTurret : public SpriteActor, public ActorCollection<WallTurret>
+// Turrets are rows of an archetype instead of actors. They never move, only
+// their guns swing, so the rects they are hit by are computed once at spawn.
+// Projectiles find them through the tree, whose proxies map back to the
+// turrets through proxyTurrets.
+class WallTurret
 {
-protected:
-    void updateCollider()
-    {
-        tak = true;
-        SpriteActor::updateCollider();
-        tak = false;
-    }
 public:
     
     enum BaseDirection{Left=0, Up=1, Right=2, Down=3};
-private:
-    
-    
     
+    struct Mount
+    {
+        BaseDirection   direction;
+        Vector2d        directionVector;
+        double          rotation;
+    };
     
-    class Gun : public SpriteActor
+    struct Gun
     {
-    public:
-        Gun()
-            : SpriteActor(textureManager.get(WallTurretSprite::path), WallTurretSprite::Gun::rect)
-        {
-            sprite.setOrigin(0, WallTurretSprite::Gun::rect.height/2);
-        }
+        sf::Sprite  sprite;
+        double      angle;
+        double      previousAngle;
+        double      waitCounter;
+        bool        isRotatingClockwise;
+        bool        isRotating;
         
-    } gun;
+        Gun(const sf::Sprite& sprite_)
+            : sprite(sprite_), angle(0), previousAngle(0), waitCounter(0), isRotatingClockwise(true), isRotating(true)
+        {}
+    };
+    
+    // Where the turret is hit, and its proxy in the tree
+    struct Target
+    {
+        Rect<double>    rect;
+        int             proxy;
+    };
     
+    typedef Archetype<Components::Position, Components::PreviousPosition, Components::Sprite, Mount, Gun, Target> Turrets;
+    typedef Turrets::Entity Entity;
     
-    BaseDirection baseDirection;
-    Vector2d directionVector = Vectors::null;
-    double gunOffset = 3;
+    static DynamicAABBTree tree;
+    
+private:
+    
+    static constexpr double minAngle    = -45;
+    static constexpr double maxAngle    = 45;
+    static constexpr double waitTime    = 1;
+    static constexpr double switchTime  = 2;
+    static constexpr double gunOffset   = 3;
+    static constexpr double scale       = 2;
     
+    static Turrets              turrets;
+    static std::vector<Entity>  proxyTurrets;
+    static std::vector<Entity>  pendingDespawns;
     
-    void updateDirectionVectorAndRotation()
+    static Mount getMount(BaseDirection direction)
     {
-        if(baseDirection == Left)
+        if(direction == Right)
         {
-            directionVector = Vector2d(1, 0);
-            setRotation(0);
+            return Mount{direction, Vector2d(-1, 0), 180};
         }
-        else if(baseDirection == Right)
+        else if(direction == Up)
         {
-            directionVector = Vector2d(-1, 0);
-            setRotation(180);
+            return Mount{direction, Vector2d(0, 1), 90};
         }
-        else if(baseDirection == Up)
+        else if(direction == Down)
         {
-            directionVector = Vector2d(0, 1);
-            setRotation(90);
+            return Mount{direction, Vector2d(0, -1), -90};
         }
-        else if(baseDirection == Down)
-        {
-            directionVector = Vector2d(0, -1);
-            setRotation(-90);
-        }
-    }
-    
-    void updateGunTransform()
-    {
-        Vector2d offsetVector = gunOffset * directionVector * getScale();
-        gun.setTransform(getTransform());
-        gun.rotate(gunAngle);
-        gun.move(offsetVector);
+        return Mount{direction, Vector2d(1, 0), 0};
     }
     
-    
-    double minAngle = -45;
-    double maxAngle = 45;
-    double waitTime = 1;
-    double switchTime = 2;
-    
-    bool gunIsRotatingClockwise = true;
-    bool gunIsRotating = true;
-    
-    double gunAngle = 0;
-    
-    double gunWaitCounter = 0;
-    void updateGunAngle(double deltaTime)
+    static void updateGunAngle(Gun& gun, double deltaTime)
     {
         bool toSwitch = false;
-        if(gunIsRotating)
+        if(gun.isRotating)
         {
-            gunAngle += deltaTime * (maxAngle - minAngle) / switchTime * (gunIsRotatingClockwise ? 1 : -1);
-            if(gunAngle > maxAngle)
+            gun.angle += deltaTime * (maxAngle - minAngle) / switchTime * (gun.isRotatingClockwise ? 1 : -1);
+            if(gun.angle > maxAngle)
             {
-                gunAngle = maxAngle;
+                gun.angle = maxAngle;
                 toSwitch = true;
             }
-            else if(gunAngle < minAngle)
+            else if(gun.angle < minAngle)
             {
-                gunAngle = minAngle;
+                gun.angle = minAngle;
                 toSwitch = true;
             }
             
             if(toSwitch)
             {
-                gunIsRotatingClockwise = !gunIsRotatingClockwise;
-                gunIsRotating = false;
+                gun.isRotatingClockwise = !gun.isRotatingClockwise;
+                gun.isRotating = false;
             }
         }
         else
         {
-            gunWaitCounter += deltaTime;
-            if(gunWaitCounter > waitTime)
+            gun.waitCounter += deltaTime;
+            if(gun.waitCounter > waitTime)
             {
-                gunWaitCounter = 0;
-                gunIsRotating = true;
+                gun.waitCounter = 0;
+                gun.isRotating = true;
             }
         }
     }
     
-public:
-    
-    void update(double deltaTime)
+    static void updateGunTransform(Gun& gun, const Mount& mount, const Vector2d& position)
     {
-        updateGunAngle(deltaTime);
-        updateGunTransform();
+        gun.sprite.setPosition(position + mount.directionVector * (gunOffset * scale));
+        gun.sprite.setRotation(mount.rotation + gun.angle);
+        gun.sprite.setScale(scale, scale);
     }
     
-    virtual void draw(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default) const
+    static void applyQueued()
     {
-        SpriteActor::draw(target, states);
-        gun.draw(target, states);
+        std::vector<Entity> despawns;
+        despawns.swap(pendingDespawns);
+        for(const Entity& turret : despawns)
+        {
+            despawn(turret);
+        }
     }
     
-    void setBaseDirection(BaseDirection bd)
+public:
+    
+    // Turrets matching the mask whose fat boxes in the tree overlap the area;
+    // what projectiles hit
+    struct Targets
     {
-        if(baseDirection == bd)
+        typedef Entity Id;
+        
+        template<class THandler>
+        void query(const Rect<double>& area, unsigned int mask, THandler handler) const
         {
-            return;
+            tree.query(area, [&handler](int proxy)
+            {
+                Entity turret = proxyTurrets[proxy];
+                handler(turrets.get<Target>(turret)->rect, turret);
+                return false;
+            }, mask);
         }
-        baseDirection = bd;
-        updateDirectionVectorAndRotation();
-    }
+    };
     
-    WallTurret(BaseDirection baseDirection_, const Vector2d& position)
-        : SpriteActor(textureManager.get(WallTurretSprite::path), WallTurretSprite::Base::rect),
-          baseDirection(baseDirection_)
+    static const Turrets& getTurrets()
     {
-        setPosition(position);
-        setScale({2,2});
-        sprite.setOrigin(0, WallTurretSprite::Base::rect.height / 2);
-        setCollider(Rect<double>(Vector2d(0, -WallTurretSprite::Base::rect.height / 2), Vector2d(WallTurretSprite::Base::rect.width, WallTurretSprite::Base::rect.height)));
-        updateDirectionVectorAndRotation();
+        return turrets;
     }
     
+    static unsigned int getCount()
+    {
+        return turrets.size();
+    }
     
+    static Entity spawn(BaseDirection baseDirection, const Vector2d& position)
+    {
+        Mount mount = getMount(baseDirection);
+        
+        // Placed by the sprite sync with every update; until then by hand
+        sf::Sprite base(textureManager.get(WallTurretSprite::path), WallTurretSprite::Base::rect);
+        base.setOrigin(0, WallTurretSprite::Base::rect.height / 2);
+        base.setPosition(position);
+        base.setScale(scale, scale);
+        base.setRotation(mount.rotation);
+        
+        Gun gun(sf::Sprite(textureManager.get(WallTurretSprite::path), WallTurretSprite::Gun::rect));
+        gun.sprite.setOrigin(0, WallTurretSprite::Gun::rect.height / 2);
+        updateGunTransform(gun, mount, position);
+        
+        ShapeCollider<Rect<double> > collider(Rect<double>(Vector2d(0, -WallTurretSprite::Base::rect.height / 2), Vector2d(WallTurretSprite::Base::rect.width, WallTurretSprite::Base::rect.height)));
+        collider.updateCollider(position, Vector2d(scale, scale), base.getRotation());
+        Target target{collider.getPositionedCollider(), tree.createProxy(collider.getBoundingRect(), nullptr, CollisionLayers::Turret)};
+        
+        Entity turret = turrets.create(Components::Position{position}, Components::PreviousPosition{position}, Components::Sprite{base}, mount, gun, target);
+        if(proxyTurrets.size() <= static_cast<unsigned int>(target.proxy))
+        {
+            proxyTurrets.resize(target.proxy + 1);
+        }
+        proxyTurrets[target.proxy] = turret;
+        return turret;
+    }
     
+    static bool despawn(const Entity& turret)
+    {
+        const Target* target = turrets.get<Target>(turret);
+        if(!target)
+        {
+            return false;
+        }
+        tree.removeProxy(target->proxy);
+        return turrets.destroy(turret);
+    }
     
+    // Safe from jobs and while the turrets are updated; applied by
+    // CollectionQueues::applyAll
+    static void queueDespawn(const Entity& turret)
+    {
+        CommandBuffer::defer([turret]
+        {
+            CollectionQueues::addOnce(&applyQueued);
+            pendingDespawns.push_back(turret);
+        });
+    }
     
+    static void despawnAll()
+    {
+        while(!turrets.empty())
+        {
+            despawn(turrets.getEntity(turrets.size() - 1));
+        }
+    }
     
+    static void savePreviousStates()
+    {
+        Systems::savePreviousPositions(turrets);
+        turrets.each<Gun>([](Gun& gun)
+        {
+            gun.previousAngle = gun.angle;
+        });
+    }
     
+    static void updateAll(double deltaTime)
+    {
+        turrets.each<Gun, Mount, Components::Position>([deltaTime](Gun& gun, const Mount& mount, const Components::Position& position)
+        {
+            updateGunAngle(gun, deltaTime);
+            updateGunTransform(gun, mount, position.value);
+        });
+        Systems::syncSprites(turrets);
+    }
     
+    static void captureAll(RenderSnapshot& snapshot)
+    {
+        Systems::captureSprites(turrets, snapshot);
+        turrets.each<Gun, Components::Position, Components::PreviousPosition>([&snapshot](const Gun& gun, const Components::Position& position, const Components::PreviousPosition& previous)
+        {
+            snapshot.addSprite(gun.sprite, position.value - previous.value, gun.angle - gun.previousAngle);
+        });
+    }
     
+    // Bases and guns go to the batch, to be drawn by its next flush
+    static void drawAll(SpriteBatch& batch, double interpolation = 1)
+    {
+        Systems::drawSprites(turrets, batch, interpolation);
+        turrets.each<Gun, Components::Position, Components::PreviousPosition>([&](const Gun& gun, const Components::Position& position, const Components::PreviousPosition& previous)
+        {
+            batch.add(gun.sprite, RenderSnapshot::interpolate(position.value, position.value - previous.value, interpolation) - position.value,
+                      (gun.angle - gun.previousAngle) * (interpolation - 1));
+        });
+    }
     
+    static void drawAll(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default, double interpolation = 1)
+    {
+        SpriteBatch batch;
+        batch.setCullRect(Culling::getViewRect(target.getView()));
+        drawAll(batch, interpolation);
+        batch.flush(target, states);
+    }
 };
 
-
+DynamicAABBTree WallTurret::tree;
+WallTurret::Turrets WallTurret::turrets;
+std::vector<WallTurret::Entity> WallTurret::proxyTurrets;
+std::vector<WallTurret::Entity> WallTurret::pendingDespawns;
+constexpr double WallTurret::minAngle;
+constexpr double WallTurret::maxAngle;
+constexpr double WallTurret::waitTime;
+constexpr double WallTurret::switchTime;
+constexpr double WallTurret::gunOffset;
+constexpr double WallTurret::scale;
 
 
 /*
@@ -7,6 +7,34 @@ bool tak = false;
 #include "Player.hpp"
 #include "WallTurret.hpp"
 #include "Cannon.hpp"
+#include "SimulationClock.hpp"
+#include "RenderThread.hpp"
+
+// Counts every heap allocation for the stats. Replacing the global new has to
+// happen in exactly one translation unit, so it isn't done in a header.
+#ifdef PRINT_STATS
+#include <cstdlib>
+#include <new>
+
+void* operator new(std::size_t size)
+{
+    AllocationStats::count();
+    if(void* memory = std::malloc(size ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+#endif // PRINT_STATS
+
 int main()
 {
     
@@ -46,15 +74,19 @@ int main()
 	
 	std::cout << "Generating map..." << std::endl;
 	
-	Room::spawn(new Room(Rect<double>(50, 15, 390, 155), WallTypes::Rocks,  platforms));
-	Room::spawn(new Room(Rect<double>(25, 170, 200, 30), WallTypes::Bricks, platforms));
-	Room::spawn(new Room(Rect<double>(40, 200, 400, 20), WallTypes::Bricks, platforms));
-	Room::spawn(new Room(Rect<double>(440, 15, 50, 300), WallTypes::Bricks, platforms));
-	Room::spawn(new Room(Rect<double>(100, 100, 40, 40), WallTypes::Bricks));
+	Room::spawn(Rect<double>(50, 15, 390, 155), WallTypes::Rocks,  platforms);
+	Room::spawn(Rect<double>(25, 170, 200, 30), WallTypes::Bricks, platforms);
+	Room::spawn(Rect<double>(40, 200, 400, 20), WallTypes::Bricks, platforms);
+	Room::spawn(Rect<double>(440, 15, 50, 300), WallTypes::Bricks, platforms);
+	Room::spawn(Rect<double>(100, 100, 40, 40), WallTypes::Bricks);
 	
 	
 	std::cout << "Adding collision platforms..." << std::endl;
     Platform::mergeAll(platforms);
+    platformGrid.build(platforms);
+    Platform::buildBVH(platforms, platformBVH);
+    Room::buildBVH();
+    Room::bakeMesh();
     
 	
 	//platforms.push_back(Platform(Vector2d(100,100), 100, true));
@@ -63,18 +95,24 @@ int main()
 	Player player(Vector2d(70, 50));
 	
 	
-	WallTurret::spawn(new WallTurret(WallTurret::Left, {50, 60}));
-	WallTurret::spawn(new WallTurret(WallTurret::Right, {150, 100}));
-	WallTurret::spawn(new WallTurret(WallTurret::Up, {200, 15}));
+	WallTurret::spawn(WallTurret::Left, {50, 60});
+	WallTurret::spawn(WallTurret::Right, {150, 100});
+	WallTurret::spawn(WallTurret::Up, {200, 15});
     
     
 	sf::Clock clock;
     double deltaTime   = 0;
     double currentTime = clock.getElapsedTime().asSeconds();
 	double lastTime    = currentTime;
-	//double subDeltaTime = 0;
 	
-	//double maxSubsteppingDeltaTime = 0.036;
+	SimulationClock simulationClock;
+	
+	// The simulation publishes a snapshot after every batch of steps, the
+	// render thread draws the latest one at the display rate
+	RenderSnapshotBuffer snapshots;
+	RenderThread         renderer(window, snapshots);
+	window.setFramerateLimit(60);
+	renderer.start();
 	
     sf::Event event;
     while (window.isOpen())
@@ -86,50 +124,60 @@ int main()
         while (window.pollEvent(event))
         {
             if (event.type == sf::Event::Closed)
+            {
+                renderer.stop();
                 window.close();
+            }
         }
 		
-		Controls::updateKeyStates();
-		
-		//std::cout << deltaTime << std::endl;
-		
 		// Update
 		
-		/*
-		while(deltaTime > 0)
+		// Keys are read once per step, so a tap is seen by exactly one step
+		unsigned int steps = simulationClock.advance(deltaTime);
+		for(unsigned int i=0; i<steps; i++)
 		{
-			subDeltaTime = deltaTime > maxSubsteppingDeltaTime ? maxSubsteppingDeltaTime : deltaTime;
-			
-			player.update(subDeltaTime);
-			Cannonball::updateAll(subDeltaTime);
-			deltaTime -= maxSubsteppingDeltaTime;
+		    Controls::updateKeyStates();
+		    
+		    player.savePreviousState();
+		    WallTurret::savePreviousStates();
+		    LightEmitter::savePreviousStates();
+		    
+		    player.update(simulationClock.getStep());
+		    Cannonball::updateAll(simulationClock.getStep());
+		    WallTurret::updateAll(simulationClock.getStep());
+		    CollectionQueues::applyAll();
 		}
-		*/
 		
-		
-		player.update(deltaTime);
-        Cannonball::updateAll(deltaTime);
-        WallTurret::updateAll(deltaTime);
-        
-        
-        // Draw
-        window.clear(sf::Color::Black);
-        
-        Room::drawAll(window);
-		/*
-        for(auto& platform : platforms)
+		if(steps > 0)
+        {
+            RenderSnapshot& snapshot = snapshots.beginWrite();
+            snapshot.step = simulationClock.getStep();
+            Room::captureAll(snapshot);
+            WallTurret::captureAll(snapshot);
+            Cannonball::captureAll(snapshot);
+            player.capture(snapshot);
+            LightEmitter::captureAll(snapshot);
+            snapshots.publish();
+        }
+        else
         {
-            platform.draw(window);
+            sf::sleep(sf::seconds(simulationClock.getTimeToNextStep()));
         }
-        */
-        WallTurret::drawAll(window);
-		Cannonball::drawAll(window);
-        player.draw(window);
-        
-        LightEmitter::generateAndApplyLightMap(window);
-        
-        window.display();
+		
+		#ifdef PRINT_STATS
+		std::cout << "steps: " << steps << " substeps: " << Actor::takeSubstepCount() << " dropped: " << simulationClock.getDroppedSteps()
+		          << " allocations: " << AllocationStats::takeHeapAllocations()
+		          << " culled: " << Culling::takeCulled() << " submitted: " << Culling::takeSubmitted();
+		const TaskGraph& frame = renderer.getFrameGraph();
+		for(unsigned int i=0; i<frame.getTasksCount(); i++)
+		{
+		    std::cout << " " << frame.getName(i) << ": " << frame.getMilliseconds(i) << "ms";
+		}
+		std::cout << std::endl;
+		#endif
     }
+    
+    renderer.stop();
 
     #endif // COL_TEST
     return 0;
@@ -0,0 +1,153 @@
+// StaticBVH against the linear scans it replaces (Room::isPointInside,
+// the light emitter platform loop and platform raycasts).
+// Runs headless, prints one line per query kind.
+
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+bool tak = false;
+#include "../Colisions.hpp"
+#include "../PLatform.hpp"
+
+template<class TFunc>
+double measure(unsigned int iterations, TFunc func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned int i=0; i<iterations; i++)
+    {
+        func(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+void report(const char* name, unsigned int count, double linear, double bvh, unsigned int mismatches)
+{
+    std::printf("%-16s n=%-6u linear %10.1f ns/op   bvh %8.1f ns/op   x%-6.1f mismatches %u\n", name, count, linear, bvh, linear / bvh, mismatches);
+}
+
+int main()
+{
+    const unsigned int queries = 20000;
+    std::mt19937 random(42);
+
+    for(unsigned int roomsCount : {100u, 1000u, 5000u})
+    {
+        double worldSize = std::sqrt(roomsCount) * 150;
+        std::uniform_real_distribution<double> coordinate(0, worldSize);
+        std::uniform_real_distribution<double> size(10, 200);
+
+        std::vector<Rect<double> > rooms;
+        platforms.clear();
+        for(unsigned int i=0; i<roomsCount; i++)
+        {
+            Rect<double> rect(coordinate(random), coordinate(random), size(random), size(random));
+            rooms.push_back(rect);
+            platforms.emplace_back(rect.getUpperLeft(),  rect.size.x, false);
+            platforms.emplace_back(rect.getBottomLeft(), rect.size.x, false);
+            platforms.emplace_back(rect.getUpperLeft(),  rect.size.y, true);
+            platforms.emplace_back(rect.getUpperRight(), rect.size.y, true);
+        }
+        Platform::mergeAll(platforms);
+
+        StaticBVH roomBVH;
+        roomBVH.build(rooms);
+        Platform::buildBVH(platforms, platformBVH);
+
+        std::vector<Vector2d> points;
+        for(unsigned int i=0; i<queries; i++)
+        {
+            points.push_back(Vector2d(coordinate(random), coordinate(random)));
+        }
+
+        // Point in room
+        std::vector<char> linearInside(queries), bvhInside(queries);
+        double linear = measure(queries, [&](unsigned int i)
+        {
+            bool inside = false;
+            for(const Rect<double>& rect : rooms)
+            {
+                inside = CollisionFast::test(points[i], rect);
+                if(inside)
+                    break;
+            }
+            linearInside[i] = inside;
+        });
+        double bvh = measure(queries, [&](unsigned int i)
+        {
+            bvhInside[i] = roomBVH.queryPoint(points[i], [&](unsigned int index)
+            {
+                return CollisionFast::test(points[i], rooms[index]);
+            });
+        });
+        unsigned int mismatches = 0;
+        for(unsigned int i=0; i<queries; i++)
+        {
+            mismatches += linearInside[i] != bvhInside[i];
+        }
+        report("point-in-room", roomsCount, linear, bvh, mismatches);
+
+        // Platforms in light radius
+        const double radius = 150;
+        std::vector<unsigned int> linearCount(queries), bvhCount(queries);
+        linear = measure(queries, [&](unsigned int i)
+        {
+            unsigned int count = 0;
+            for(const Platform& platform : platforms)
+            {
+                const Rect<double> box = platform.collider.getBoundingRect();
+                double dx = std::max(std::max(box.position.x - points[i].x, points[i].x - box.position.x - box.size.x), 0.0);
+                double dy = std::max(std::max(box.position.y - points[i].y, points[i].y - box.position.y - box.size.y), 0.0);
+                count += dx*dx + dy*dy <= radius*radius;
+            }
+            linearCount[i] = count;
+        });
+        bvh = measure(queries, [&](unsigned int i)
+        {
+            unsigned int count = 0;
+            platformBVH.queryRadius(points[i], radius, [&count](unsigned int){count++; return false;});
+            bvhCount[i] = count;
+        });
+        mismatches = 0;
+        for(unsigned int i=0; i<queries; i++)
+        {
+            mismatches += linearCount[i] != bvhCount[i];
+        }
+        report("radius", platforms.size(), linear, bvh, mismatches);
+
+        // First hit of a short shot
+        std::vector<double> linearHit(queries), bvhHit(queries);
+        auto getShot = [&](unsigned int i)
+        {
+            return Line<double>(points[i], points[i] + Vector2d(std::cos(i), std::sin(i)) * 300.0);
+        };
+        linear = measure(queries, [&](unsigned int i)
+        {
+            Line<double> shot = getShot(i);
+            double best = 2, fraction;
+            for(const Platform& platform : platforms)
+            {
+                if(Collision::raycast(shot, platform.collider, fraction) && fraction < best)
+                {
+                    best = fraction;
+                }
+            }
+            linearHit[i] = best;
+        });
+        bvh = measure(queries, [&](unsigned int i)
+        {
+            unsigned int index;
+            double fraction;
+            bvhHit[i] = Platform::raycast(platforms, platformBVH, getShot(i), index, fraction) ? fraction : 2;
+        });
+        mismatches = 0;
+        for(unsigned int i=0; i<queries; i++)
+        {
+            mismatches += linearHit[i] != bvhHit[i];
+        }
+        report("raycast", platforms.size(), linear, bvh, mismatches);
+    }
+    return 0;
+}
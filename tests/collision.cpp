@@ -1,3 +1,248 @@
-#include "../Collisions_v2.hpp"
+// Narrowphase benchmark: ns/op of every pair Collision::test supports
+// (Point, SimpleSegment, Rect, Circle, Line, Polygon), separately for
+// overlapping pairs, far apart pairs, uniformly random pairs and degenerate
+// shapes (zero sizes, zero lengths, collinear polygons, touching edges).
+// Runs headless, prints CSV, or JSON with --json.
+//
+// Usage: collision [--json] [--iterations N] [--seed N]
 
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+bool tak = false;
+#include "../Colisions.hpp"
 
+enum Case {Hit, Miss, Random, Degenerate, CasesCount};
+
+const char* caseNames[CasesCount] = {"hit", "miss", "random", "degenerate"};
+
+std::mt19937 generator(1);
+
+double uniform(double a, double b)
+{
+    return std::uniform_real_distribution<double>(a, b)(generator);
+}
+
+// Center of the second shape of a pair, relative to the first one
+Vector2d pairOffset(Case c)
+{
+    switch(c)
+    {
+    case Hit:
+        return Vector2d(uniform(-1, 1), uniform(-1, 1));
+    case Miss:
+        return Vector2d(uniform(60, 100), uniform(60, 100));
+    case Random:
+        return Vector2d(uniform(-30, 30), uniform(-30, 30));
+    default:
+        return Vector2d(generator() % 3 * 5.0, generator() % 3 * 5.0);
+    }
+}
+
+// Shapes are built around a center, sized about 10 units
+template<class T>
+T makeShape(const Vector2d& center, bool degenerate);
+
+template<>
+Vector2d makeShape<Vector2d>(const Vector2d& center, bool)
+{
+    return center;
+}
+
+template<>
+Rect<double> makeShape<Rect<double> >(const Vector2d& center, bool degenerate)
+{
+    if(degenerate)
+    {
+        return Rect<double>(center, Vector2d(generator() % 2 * 10.0, 0));
+    }
+    Vector2d size(uniform(2, 20), uniform(2, 20));
+    return Rect<double>(center - size / 2.0, size);
+}
+
+template<>
+Circle<double> makeShape<Circle<double> >(const Vector2d& center, bool degenerate)
+{
+    return Circle<double>(center, degenerate ? 0 : uniform(1, 10));
+}
+
+template<>
+SimpleSegment<double> makeShape<SimpleSegment<double> >(const Vector2d& center, bool degenerate)
+{
+    bool isVertical = generator() % 2;
+    double length   = degenerate ? 0 : uniform(2, 20);
+    Vector2d start  = center - (isVertical ? Vector2d(0, length / 2) : Vector2d(length / 2, 0));
+    return SimpleSegment<double>(start, length, isVertical);
+}
+
+template<>
+Line<double> makeShape<Line<double> >(const Vector2d& center, bool degenerate)
+{
+    if(degenerate)
+    {
+        return Line<double>(center, center);
+    }
+    double angle  = uniform(0, 2 * M_PI);
+    Vector2d half = Vector2d(std::cos(angle), std::sin(angle)) * uniform(1, 10);
+    return Line<double>(center - half, center + half);
+}
+
+template<>
+Polygon<double> makeShape<Polygon<double> >(const Vector2d& center, bool degenerate)
+{
+    if(degenerate)
+    {
+        // Collinear, with a repeated vertex
+        Vector2d direction(uniform(-1, 1), uniform(-1, 1));
+        Polygon<double> poly({center - direction * 5.0, center, center, center + direction * 5.0});
+        poly.checkConvex();
+        return poly;
+    }
+    // Convex, 3 to 8 vertices on a circle
+    unsigned int count = 3 + generator() % 6;
+    std::vector<double> angles;
+    for(unsigned int i=0; i<count; i++)
+    {
+        angles.push_back(uniform(0, 2 * M_PI));
+    }
+    std::sort(angles.begin(), angles.end());
+    double radius = uniform(2, 10);
+    Polygon<double> poly;
+    for(double angle : angles)
+    {
+        poly.append(center + Vector2d(std::cos(angle), std::sin(angle)) * radius);
+    }
+    poly.checkConvex();
+    return poly;
+}
+
+template<class T> const char* shapeName();
+template<> const char* shapeName<Vector2d>()                {return "Point";}
+template<> const char* shapeName<SimpleSegment<double> >()  {return "SimpleSegment";}
+template<> const char* shapeName<Rect<double> >()           {return "Rect";}
+template<> const char* shapeName<Circle<double> >()         {return "Circle";}
+template<> const char* shapeName<Line<double> >()           {return "Line";}
+template<> const char* shapeName<Polygon<double> >()        {return "Polygon";}
+
+struct Measurement
+{
+    std::string pair;
+    const char* caseName;
+    double      nsPerOp;
+    double      hitRate;
+};
+
+std::vector<Measurement> measurements;
+unsigned int iterations = 200000;
+unsigned int sink = 0;
+
+template<class A, class B>
+void benchmarkPair()
+{
+    const unsigned int pairsCount  = 512;
+    const unsigned int repetitions = 5;
+
+    for(int c = 0; c < CasesCount; c++)
+    {
+        std::vector<A> as;
+        std::vector<B> bs;
+        for(unsigned int i=0; i<pairsCount; i++)
+        {
+            Vector2d center(uniform(-1000, 1000), uniform(-1000, 1000));
+            as.push_back(makeShape<A>(center, c == Degenerate && i % 2 == 0));
+            bs.push_back(makeShape<B>(center + pairOffset(Case(c)), c == Degenerate && i % 2 == 1));
+        }
+
+        unsigned int hits = 0;
+        for(unsigned int i=0; i<pairsCount; i++)
+        {
+            hits += bool(Collision::test(as[i], bs[i]));
+        }
+
+        // Best of a few runs, so the numbers are stable enough to compare between builds
+        double best = 0;
+        for(unsigned int r=0; r<repetitions; r++)
+        {
+            unsigned int count = 0;
+            auto start = std::chrono::steady_clock::now();
+            for(unsigned int i=0; i<iterations; i++)
+            {
+                count += bool(Collision::test(as[i % pairsCount], bs[i % pairsCount]));
+            }
+            auto end = std::chrono::steady_clock::now();
+            sink += count;
+            double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+            if(r == 0 || ns < best)
+            {
+                best = ns;
+            }
+        }
+
+        measurements.push_back({std::string(shapeName<A>()) + "-" + shapeName<B>(), caseNames[c], best, double(hits) / pairsCount});
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool json = false;
+    for(int i=1; i<argc; i++)
+    {
+        if(std::strcmp(argv[i], "--json") == 0)
+            json = true;
+        else if(std::strcmp(argv[i], "--iterations") == 0 && i+1 < argc)
+            iterations = std::max(1, std::atoi(argv[++i]));
+        else if(std::strcmp(argv[i], "--seed") == 0 && i+1 < argc)
+            generator.seed(std::atoi(argv[++i]));
+    }
+
+    benchmarkPair<Vector2d, Rect<double> >();
+    benchmarkPair<Vector2d, Circle<double> >();
+    benchmarkPair<Vector2d, Polygon<double> >();
+
+    benchmarkPair<SimpleSegment<double>, SimpleSegment<double> >();
+    benchmarkPair<SimpleSegment<double>, Rect<double> >();
+    benchmarkPair<SimpleSegment<double>, Circle<double> >();
+    benchmarkPair<SimpleSegment<double>, Line<double> >();
+    benchmarkPair<SimpleSegment<double>, Polygon<double> >();
+
+    benchmarkPair<Rect<double>, Rect<double> >();
+    benchmarkPair<Rect<double>, Circle<double> >();
+    benchmarkPair<Rect<double>, Line<double> >();
+    benchmarkPair<Rect<double>, Polygon<double> >();
+
+    benchmarkPair<Circle<double>, Circle<double> >();
+    benchmarkPair<Circle<double>, Line<double> >();
+    benchmarkPair<Circle<double>, Polygon<double> >();
+
+    benchmarkPair<Line<double>, Line<double> >();
+    benchmarkPair<Line<double>, Polygon<double> >();
+
+    benchmarkPair<Polygon<double>, Polygon<double> >();
+
+    if(json)
+    {
+        std::printf("[\n");
+        for(unsigned int i=0; i<measurements.size(); i++)
+        {
+            const Measurement& m = measurements[i];
+            std::printf("  {\"pair\": \"%s\", \"case\": \"%s\", \"ns_per_op\": %.3f, \"hit_rate\": %.3f}%s\n",
+                        m.pair.c_str(), m.caseName, m.nsPerOp, m.hitRate, i+1 < measurements.size() ? "," : "");
+        }
+        std::printf("]\n");
+    }
+    else
+    {
+        std::printf("pair,case,ns_per_op,hit_rate\n");
+        for(const Measurement& m : measurements)
+        {
+            std::printf("%s,%s,%.3f,%.3f\n", m.pair.c_str(), m.caseName, m.nsPerOp, m.hitRate);
+        }
+    }
+    return sink == 0xFFFFFFFF;
+}
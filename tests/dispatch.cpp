@@ -0,0 +1,137 @@
+// Pair test throughput of Collider::test, through the dispatch table, against
+// the previous double virtual dispatch (first hop on the tested collider,
+// second one on the other collider's per-shape test overload).
+// Runs headless, prints one line per shape pair.
+
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+bool tak = false;
+#include "../Colisions.hpp"
+
+// The old Collider::test(const Collider&) path
+class DoubleDispatch
+{
+public:
+    virtual Collision::Result test(const Collider& c) const = 0;
+    virtual ~DoubleDispatch(){}
+};
+
+template<class T>
+class DoubleDispatchShape : public DoubleDispatch
+{
+    T shape;
+public:
+    virtual Collision::Result test(const Collider& c) const
+    {
+        return c.test(shape);
+    }
+    DoubleDispatchShape(const T& shape_)
+        : shape(shape_)
+    {}
+};
+
+std::mt19937 generator(7);
+std::uniform_real_distribution<double> coordinate(0, 20);
+std::uniform_real_distribution<double> extent(1, 10);
+
+Vector2d randomPoint()
+{
+    return Vector2d(coordinate(generator), coordinate(generator));
+}
+
+Rect<double> randomRect()
+{
+    return Rect<double>(randomPoint(), Vector2d(extent(generator), extent(generator)));
+}
+
+Collider* makeCollider(Collision::ShapeType type, DoubleDispatch*& doubleDispatch)
+{
+    switch(type)
+    {
+    case Collision::RectShape:
+        {
+            Rect<double> shape = randomRect();
+            doubleDispatch = new DoubleDispatchShape<Rect<double> >(shape);
+            return new FixedRectCollider(shape);
+        }
+    case Collision::CircleShape:
+        {
+            Circle<double> shape(randomPoint(), extent(generator));
+            doubleDispatch = new DoubleDispatchShape<Circle<double> >(shape);
+            return new FixedCircleCollider(shape);
+        }
+    case Collision::SimpleSegmentShape:
+        {
+            SimpleSegment<double> shape(randomPoint(), extent(generator), generator() % 2);
+            doubleDispatch = new DoubleDispatchShape<SimpleSegment<double> >(shape);
+            return new FixedSimpleSegmentCollider(shape);
+        }
+    case Collision::LineShape:
+        {
+            Line<double> shape(randomPoint(), randomPoint());
+            doubleDispatch = new DoubleDispatchShape<Line<double> >(shape);
+            return new FixedLineCollider(shape);
+        }
+    default:
+        {
+            Polygon<double> shape = randomRect().toPolygon();
+            doubleDispatch = new DoubleDispatchShape<Polygon<double> >(shape);
+            return new FixedPolygonCollider(shape);
+        }
+    }
+}
+
+const char* shapeNames[Collision::ShapeTypesCount] = {"Rect", "Circle", "SimpleSegment", "Line", "Polygon"};
+
+int main()
+{
+    const unsigned int count      = 256;
+    const unsigned int iterations = 200000;
+
+    std::printf("pair,double_dispatch_ns,table_ns,speedup\n");
+    for(int a = 0; a < Collision::ShapeTypesCount; a++)
+    {
+        for(int b = 0; b < Collision::ShapeTypesCount; b++)
+        {
+            std::vector<Collider*>          collidersA, collidersB;
+            std::vector<DoubleDispatch*>    doubleA, doubleB;
+            for(unsigned int i=0; i<count; i++)
+            {
+                DoubleDispatch* d;
+                collidersA.push_back(makeCollider(Collision::ShapeType(a), d));
+                doubleA.push_back(d);
+                collidersB.push_back(makeCollider(Collision::ShapeType(b), d));
+                doubleB.push_back(d);
+            }
+
+            unsigned int hitsOld = 0, hitsNew = 0;
+            auto start = std::chrono::steady_clock::now();
+            for(unsigned int i=0; i<iterations; i++)
+            {
+                hitsOld += bool(doubleA[i % count]->test(*collidersB[(i * 7) % count]));
+            }
+            auto middle = std::chrono::steady_clock::now();
+            for(unsigned int i=0; i<iterations; i++)
+            {
+                hitsNew += bool(collidersA[i % count]->test(*collidersB[(i * 7) % count]));
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            double oldNs = std::chrono::duration<double, std::nano>(middle - start).count() / iterations;
+            double newNs = std::chrono::duration<double, std::nano>(end - middle).count() / iterations;
+            std::printf("%s-%s,%.2f,%.2f,%.2f%s\n", shapeNames[a], shapeNames[b], oldNs, newNs, oldNs / newNs, hitsOld != hitsNew ? ",MISMATCH" : "");
+
+            for(unsigned int i=0; i<count; i++)
+            {
+                delete collidersA[i];
+                delete collidersB[i];
+                delete doubleA[i];
+                delete doubleB[i];
+            }
+        }
+    }
+    return 0;
+}